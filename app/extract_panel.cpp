@@ -0,0 +1,97 @@
+#include "extract_panel.h"
+
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QTimer>
+
+#include <algorithm>
+
+ExtractPanel::ExtractPanel(QWidget *parent) : QWidget(parent) {
+    auto *layout = new QHBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+
+    m_fileLabel = new QLabel(this);
+    m_fileLabel->setMinimumWidth(200);
+    m_fileLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    m_bar = new QProgressBar(this);
+    m_bar->setRange(0, 1000);
+    m_bar->setMaximumWidth(260);
+    m_rateLabel = new QLabel(this);
+    m_stopButton = new QPushButton("Stop", this);
+
+    layout->addWidget(m_fileLabel, 1);
+    layout->addWidget(m_bar);
+    layout->addWidget(m_rateLabel);
+    layout->addWidget(m_stopButton);
+
+    m_timer = new QTimer(this);
+    m_timer->setInterval(200);
+    connect(m_timer, &QTimer::timeout, this, &ExtractPanel::refresh);
+    connect(m_stopButton, &QPushButton::clicked, this, [this]() {
+        if (m_progress) {
+            m_progress->cancel();
+            m_stopButton->setEnabled(false);
+            m_fileLabel->setText("Stopping...");
+        }
+    });
+
+    hide();
+}
+
+void ExtractPanel::start(std::shared_ptr<swcore::ExtractProgress> progress) {
+    m_progress = std::move(progress);
+    m_elapsed.start();
+    m_bar->setValue(0);
+    m_fileLabel->clear();
+    m_rateLabel->clear();
+    m_stopButton->setEnabled(true);
+    m_timer->start();
+    show();
+}
+
+void ExtractPanel::finish() {
+    m_timer->stop();
+    m_progress.reset();
+    hide();
+}
+
+void ExtractPanel::refresh() {
+    if (!m_progress || m_progress->isCanceled()) {
+        return;
+    }
+
+    const int entriesDone = m_progress->entriesDone();
+    const int entriesTotal = m_progress->entriesTotal();
+    const qint64 bytesDone = m_progress->bytesDone();
+    const qint64 bytesTotal = m_progress->bytesTotal();
+    m_fileLabel->setText(QString("%1 (%2/%3)").arg(m_progress->currentFile()).arg(entriesDone).arg(entriesTotal));
+
+    // The bar is weighted by payload bytes; runs without payloads (only
+    // directories and links) fall back to entry counts.
+    if (bytesTotal > 0) {
+        m_bar->setValue(int(double(bytesDone) * 1000 / double(bytesTotal)));
+    } else {
+        m_bar->setValue(entriesTotal > 0 ? int(qint64(entriesDone) * 1000 / entriesTotal) : 0);
+    }
+
+    // Throughput is payload bytes read from the subproduct files.
+    const double seconds = std::max<qint64>(1, m_elapsed.elapsed()) / 1000.0;
+    const double rate = bytesDone / seconds;
+    QString text = QString("%1 MB/s").arg(rate / (1024.0 * 1024.0), 0, 'f', 1);
+    if (rate > 0 && bytesTotal > bytesDone) {
+        text += QString("  ETA %1").arg(formatDuration(qint64((bytesTotal - bytesDone) / rate)));
+    }
+    m_rateLabel->setText(text);
+}
+
+QString ExtractPanel::formatDuration(qint64 seconds) {
+    if (seconds >= 3600) {
+        return QString("%1:%2:%3")
+            .arg(seconds / 3600)
+            .arg((seconds / 60) % 60, 2, 10, QChar('0'))
+            .arg(seconds % 60, 2, 10, QChar('0'));
+    }
+    return QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "swcore/extractor.h"
+
+#include <QElapsedTimer>
+#include <QWidget>
+
+#include <memory>
+
+class QLabel;
+class QProgressBar;
+class QPushButton;
+class QTimer;
+
+// Non-modal progress strip for a background extraction. It polls the shared
+// ExtractProgress on a timer and shows the current file, throughput and ETA;
+// the Stop button cancels through the same channel.
+class ExtractPanel : public QWidget {
+    Q_OBJECT
+public:
+    explicit ExtractPanel(QWidget *parent = nullptr);
+
+    void start(std::shared_ptr<swcore::ExtractProgress> progress);
+    void finish();
+
+private:
+    void refresh();
+    static QString formatDuration(qint64 seconds);
+
+    std::shared_ptr<swcore::ExtractProgress> m_progress;
+    QElapsedTimer m_elapsed;
+    QLabel *m_fileLabel = nullptr;
+    QLabel *m_rateLabel = nullptr;
+    QProgressBar *m_bar = nullptr;
+    QPushButton *m_stopButton = nullptr;
+    QTimer *m_timer = nullptr;
+};
@@ -1,24 +1,14 @@
 #include "file_table_model.h"
 
 #include <QApplication>
+#include <QFutureWatcher>
 #include <QList>
-#include <QMap>
 #include <QSet>
 #include <QStyle>
+#include <QtConcurrent>
 
 #include <algorithm>
 
-namespace {
-
-QString joinPath(const QString &parent, const QString &name) {
-    if (parent.isEmpty()) {
-        return name;
-    }
-    return parent + "/" + name;
-}
-
-} // namespace
-
 FileTableModel::FileTableModel(QObject *parent) : QAbstractTableModel(parent) {
     if (qApp) {
         m_upIcon = qApp->style()->standardIcon(QStyle::SP_FileDialogToParent);
@@ -26,6 +16,14 @@ FileTableModel::FileTableModel(QObject *parent) : QAbstractTableModel(parent) {
         m_fileIcon = qApp->style()->standardIcon(QStyle::SP_FileIcon);
         m_linkIcon = qApp->style()->standardIcon(QStyle::SP_FileLinkIcon);
     }
+
+    RebuildRequest empty;
+    empty.store = m_store;
+    empty.mask = m_subgroupMask;
+    m_snapshot = buildSnapshot(empty, nullptr);
+
+    m_rebuildWatcher = new QFutureWatcher<std::shared_ptr<const Snapshot>>(this);
+    connect(m_rebuildWatcher, &QFutureWatcherBase::finished, this, &FileTableModel::rebuildFinished);
 }
 
 int FileTableModel::rowCount(const QModelIndex &parent) const {
@@ -47,25 +45,28 @@ QVariant FileTableModel::data(const QModelIndex &index, int role) const {
         return {};
     }
 
-    const RowItem &row = m_rows.at(index.row());
+    const int slot = m_rows.at(index.row());
+    const RowKind kind = slotKind(slot);
+    const int entryIndex = slotEntry(slot);
+    const bool link = entryIndex >= 0 && store().ftype(entryIndex) == 'l';
 
     if (role == Qt::DecorationRole && index.column() == 0) {
-        if (row.kind == RowKind::Parent) {
+        if (kind == RowKind::Parent) {
             return m_upIcon;
         }
-        if (row.kind == RowKind::Directory) {
+        if (kind == RowKind::Directory) {
             return m_dirIcon;
         }
-        if (row.kind == RowKind::DirectoryLink || row.ftype == 'l') {
+        if (link) {
             return m_linkIcon.isNull() ? m_fileIcon : m_linkIcon;
         }
         return m_fileIcon;
     }
 
     if (role == Qt::ToolTipRole) {
-        if (row.ftype == 'l') {
-            QString tip = QString("%1 -> %2").arg(row.name, row.linkTarget);
-            if (row.kind == RowKind::DirectoryLink) {
+        if (link) {
+            QString tip = QString("%1 -> %2").arg(store().baseName(entryIndex).toString(), store().entry(entryIndex).symval);
+            if (kind == RowKind::DirectoryLink) {
                 tip += "\nDouble-click to enter target directory";
             }
             return tip;
@@ -77,39 +78,45 @@ QVariant FileTableModel::data(const QModelIndex &index, int role) const {
         return {};
     }
 
+    const bool entry = kind == RowKind::Entry;
     switch (index.column()) {
     case 0:
-        if (row.kind == RowKind::Parent) {
+        if (kind == RowKind::Parent) {
             return "..";
         }
-        if (row.ftype == 'l') {
-            return QString("%1 -> %2").arg(row.name, row.linkTarget);
+        if (kind == RowKind::Directory) {
+            return tree().node(slotDir(slot)).name;
+        }
+        if (link) {
+            return QString("%1 -> %2").arg(store().baseName(entryIndex).toString(), store().entry(entryIndex).symval);
         }
-        return row.name;
+        return store().baseName(entryIndex).toString();
     case 1:
-        return row.kind == RowKind::Entry ? QVariant(row.size) : QVariant();
+        return entry ? QVariant(store().fileSize(entryIndex)) : QVariant();
     case 2:
-        return row.kind == RowKind::Entry ? QVariant(row.packed) : QVariant();
+        return entry ? QVariant(store().packedSize(entryIndex)) : QVariant();
     case 3:
-        if (row.kind == RowKind::Parent) {
+        if (kind == RowKind::Parent) {
             return "UP";
         }
-        if (row.kind == RowKind::Directory) {
+        if (kind == RowKind::Directory) {
             return "DIR";
         }
-        if (row.kind == RowKind::DirectoryLink) {
+        if (kind == RowKind::DirectoryLink) {
             return "LNKD";
         }
-        if (row.ftype == 'l') {
+        if (link) {
             return "LNK";
         }
-        return QString(row.ftype);
+        return QString(QChar::fromLatin1(store().ftype(entryIndex)));
     case 4:
-        return row.kind == RowKind::Entry ? QVariant(row.subgroup) : QVariant();
+        // Subgroup and mach are interned in the parse result; read them from
+        // the store instead of copying them into every row.
+        return entry ? QVariant(store().subgroups().at(store().subgroupId(entryIndex))) : QVariant();
     case 5:
-        return row.kind == RowKind::Entry ? QVariant(row.mach) : QVariant();
+        return entry ? QVariant(store().entry(entryIndex).machExpr) : QVariant();
     case 6:
-        return row.kind == RowKind::Entry ? QVariant(row.offset) : QVariant();
+        return entry ? QVariant(store().offset(entryIndex)) : QVariant();
     default:
         return {};
     }
@@ -141,45 +148,39 @@ QVariant FileTableModel::headerData(int section, Qt::Orientation orientation, in
 }
 
 void FileTableModel::setEntries(QVector<swcore::FileEntry> entries) {
-    beginResetModel();
-    m_entries = std::move(entries);
-    m_cachedPaths.clear();
-    m_cachedPaths.reserve(m_entries.size());
-    for (const swcore::FileEntry &e : m_entries) {
-        CachedEntryPath c;
-        c.fullPath = normalizedPath(e.fname);
-        c.parentPath = parentOf(c.fullPath);
-        c.baseName = baseNameOf(c.fullPath);
-        c.baseNameLower = c.baseName.toLower();
-        m_cachedPaths.push_back(std::move(c));
-    }
-    m_currentDir.clear();
-    rebuildSubgroupFiltered();
-    rebuildRows();
-    endResetModel();
+    m_store = std::make_shared<const swcore::EntryStore>(std::move(entries));
+    m_index.reset();
+    m_requestedDir.clear();
+    scheduleRebuild();
+    buildPathIndex();
+}
+
+void FileTableModel::buildPathIndex() {
+    // Path queries scan the filtered entries until the index is ready.
+    const quint64 generation = ++m_indexGeneration;
+    if (m_store->isEmpty()) {
+        return;
+    }
+    auto *watcher = new QFutureWatcher<std::shared_ptr<const swcore::PathIndex>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, generation]() {
+        if (generation == m_indexGeneration) {
+            m_index = watcher->result();
+        }
+        watcher->deleteLater();
+    });
+    const std::shared_ptr<const swcore::EntryStore> store = m_store;
+    watcher->setFuture(QtConcurrent::run([store]() { return std::make_shared<const swcore::PathIndex>(*store); }));
 }
 
 void FileTableModel::setFilters(const QString &mask, const QString &filter) {
     const QString normalized = mask.trimmed().isEmpty() ? "*" : mask.trimmed();
     const QString normalizedFilter = filter.trimmed();
-    const bool subgroupChanged = normalized != m_subgroupMask;
-    const bool nameChanged = normalizedFilter != m_nameFilter;
-    if (!subgroupChanged && !nameChanged) {
+    if (normalized == m_subgroupMask && normalizedFilter == m_nameFilter) {
         return;
     }
-
-    beginResetModel();
-    if (subgroupChanged) {
-        m_subgroupMask = normalized;
-        m_subgroupRegex = QRegularExpression(QRegularExpression::wildcardToRegularExpression(m_subgroupMask));
-        rebuildSubgroupFiltered();
-    }
-    if (nameChanged) {
-        m_nameFilter = normalizedFilter;
-        m_nameFilterLower = normalizedFilter.toLower();
-    }
-    rebuildRows();
-    endResetModel();
+    m_subgroupMask = normalized;
+    m_nameFilter = normalizedFilter;
+    scheduleRebuild();
 }
 
 void FileTableModel::setSubgroupMask(const QString &mask) {
@@ -192,53 +193,62 @@ void FileTableModel::setNameFilter(const QString &filter) {
 
 void FileTableModel::setCurrentDirectory(const QString &relPath) {
     const QString normalized = normalizedPath(relPath);
-    if (normalized == m_currentDir) {
+    if (normalized == m_requestedDir) {
         return;
     }
-    beginResetModel();
-    m_currentDir = normalized;
-    rebuildRows();
-    endResetModel();
+    m_requestedDir = normalized;
+    scheduleRebuild();
 }
 
 QString FileTableModel::currentDirectory() const {
-    return m_currentDir;
+    return m_snapshot->currentDir;
 }
 
 bool FileTableModel::canGoUp() const {
-    return !m_currentDir.isEmpty();
+    return !m_requestedDir.isEmpty();
 }
 
 void FileTableModel::goUp() {
     if (!canGoUp()) {
         return;
     }
-    setCurrentDirectory(parentOf(m_currentDir));
+    setCurrentDirectory(parentOf(m_requestedDir));
 }
 
 FileTableModel::RowKind FileTableModel::rowKind(int row) const {
     if (row < 0 || row >= m_rows.size()) {
         return RowKind::Entry;
     }
-    return m_rows.at(row).kind;
+    return slotKind(m_rows.at(row));
 }
 
 QString FileTableModel::rowPath(int row) const {
     if (row < 0 || row >= m_rows.size()) {
         return {};
     }
-    const RowItem &item = m_rows.at(row);
-    if (!item.navigatePath.isEmpty()) {
-        return item.navigatePath;
+    const int entryIndex = slotEntry(m_rows.at(row));
+    if (entryIndex >= 0 && store().ftype(entryIndex) == 'l') {
+        const QString &navigatePath = linkInfo(entryIndex).navigatePath;
+        if (!navigatePath.isEmpty()) {
+            return navigatePath;
+        }
     }
-    return item.relPath;
+    return rowSourcePath(row);
 }
 
 QString FileTableModel::rowSourcePath(int row) const {
     if (row < 0 || row >= m_rows.size()) {
         return {};
     }
-    return m_rows.at(row).relPath;
+    const int slot = m_rows.at(row);
+    if (slot < 0) {
+        return parentOf(m_snapshot->currentDir);
+    }
+    const int dirNode = slotDir(slot);
+    if (dirNode >= 0) {
+        return tree().node(dirNode).path;
+    }
+    return store().path(slotEntry(slot)).toString();
 }
 
 QVector<swcore::FileEntry> FileTableModel::entriesForRows(const QModelIndexList &rows) const {
@@ -247,28 +257,21 @@ QVector<swcore::FileEntry> FileTableModel::entriesForRows(const QModelIndexList
         if (!idx.isValid() || idx.row() < 0 || idx.row() >= m_rows.size()) {
             continue;
         }
-        const RowItem &row = m_rows.at(idx.row());
-        if (row.kind == RowKind::Parent) {
-            continue;
-        }
-        if (row.kind == RowKind::DirectoryLink) {
-            if (row.entryIndex >= 0) {
-                indexes.insert(row.entryIndex);
-            }
+        const int slot = m_rows.at(idx.row());
+        const int entryIndex = slotEntry(slot);
+        if (entryIndex >= 0) {
+            indexes.insert(entryIndex);
             continue;
         }
-        if (row.kind == RowKind::Entry) {
-            if (row.entryIndex >= 0) {
-                indexes.insert(row.entryIndex);
-            }
+        const int dirNode = slotDir(slot);
+        if (dirNode < 0) {
             continue;
         }
 
-        for (int entryIndex : m_subgroupFilteredIndexes) {
-            const CachedEntryPath &path = m_cachedPaths.at(entryIndex);
-            if (isUnderOrEqual(path.fullPath, row.relPath)) {
-                indexes.insert(entryIndex);
-            }
+        std::vector<int> subtree;
+        tree().collectEntries(dirNode, &subtree);
+        for (int subtreeIndex : subtree) {
+            indexes.insert(subtreeIndex);
         }
     }
 
@@ -277,9 +280,14 @@ QVector<swcore::FileEntry> FileTableModel::entriesForRows(const QModelIndexList
 
 QVector<swcore::FileEntry> FileTableModel::entriesInCurrentTree() const {
     QSet<int> indexes;
-    for (int entryIndex : m_subgroupFilteredIndexes) {
-        const CachedEntryPath &path = m_cachedPaths.at(entryIndex);
-        if (m_currentDir.isEmpty() || isUnderOrEqual(path.fullPath, m_currentDir)) {
+    if (m_snapshot->currentDir.isEmpty()) {
+        for (int entryIndex : m_snapshot->view->subgroups->indexes) {
+            indexes.insert(entryIndex);
+        }
+    } else {
+        std::vector<int> subtree;
+        tree().collectEntries(tree().findDir(m_snapshot->currentDir), &subtree);
+        for (int entryIndex : subtree) {
             indexes.insert(entryIndex);
         }
     }
@@ -287,31 +295,11 @@ QVector<swcore::FileEntry> FileTableModel::entriesInCurrentTree() const {
 }
 
 int FileTableModel::totalFilteredEntryCount() const {
-    return m_subgroupFilteredIndexes.size();
+    return m_snapshot->view->subgroups->indexes.size();
 }
 
 QString FileTableModel::normalizedPath(const QString &path) {
-    QString p = path;
-    p.replace('\\', '/');
-    while (p.startsWith('/')) {
-        p.remove(0, 1);
-    }
-
-    QStringList out;
-    const QStringList segs = p.split('/', Qt::SkipEmptyParts);
-    for (const QString &seg : segs) {
-        if (seg == ".") {
-            continue;
-        }
-        if (seg == "..") {
-            if (!out.isEmpty()) {
-                out.removeLast();
-            }
-            continue;
-        }
-        out.push_back(seg);
-    }
-    return out.join('/');
+    return swcore::EntryStore::normalizedPath(path);
 }
 
 QString FileTableModel::parentOf(const QString &path) {
@@ -322,14 +310,6 @@ QString FileTableModel::parentOf(const QString &path) {
     return path.left(slash);
 }
 
-QString FileTableModel::baseNameOf(const QString &path) {
-    const int slash = path.lastIndexOf('/');
-    if (slash < 0) {
-        return path;
-    }
-    return path.mid(slash + 1);
-}
-
 QString FileTableModel::resolveLinkPath(const QString &baseDir, const QString &target) {
     QString t = target;
     t.replace('\\', '/');
@@ -345,18 +325,45 @@ QString FileTableModel::resolveLinkPath(const QString &baseDir, const QString &t
     return normalizedPath(baseDir + "/" + t);
 }
 
-bool FileTableModel::isUnderOrEqual(const QString &path, const QString &dir) {
-    if (dir.isEmpty()) {
-        return true;
+int FileTableModel::slotDir(int slot) const {
+    if (slot < 0 || m_snapshot->dirId < 0) {
+        return -1;
     }
-    return path == dir || path.startsWith(dir + "/");
+    const swcore::DirectoryTree::Node &dir = tree().node(m_snapshot->dirId);
+    return size_t(slot) < dir.dirs.size() ? dir.dirs[size_t(slot)] : -1;
 }
 
-bool FileTableModel::isUnder(const QString &path, const QString &dir) {
-    if (dir.isEmpty()) {
-        return !path.isEmpty();
+int FileTableModel::slotEntry(int slot) const {
+    if (slot < 0 || m_snapshot->dirId < 0) {
+        return -1;
     }
-    return path.startsWith(dir + "/");
+    const swcore::DirectoryTree::Node &dir = tree().node(m_snapshot->dirId);
+    return size_t(slot) < dir.dirs.size() ? -1 : dir.files[size_t(slot) - dir.dirs.size()];
+}
+
+FileTableModel::RowKind FileTableModel::slotKind(int slot) const {
+    if (slot < 0) {
+        return RowKind::Parent;
+    }
+    const int entryIndex = slotEntry(slot);
+    if (entryIndex < 0) {
+        return RowKind::Directory;
+    }
+    if (store().ftype(entryIndex) == 'l' && linkInfo(entryIndex).directory) {
+        return RowKind::DirectoryLink;
+    }
+    return RowKind::Entry;
+}
+
+const FileTableModel::LinkInfo &FileTableModel::linkInfo(int entryIndex) const {
+    auto it = m_linkCache.find(entryIndex);
+    if (it == m_linkCache.end()) {
+        LinkInfo info;
+        info.navigatePath = resolveLinkPath(m_snapshot->currentDir, store().entry(entryIndex).symval);
+        info.directory = !info.navigatePath.isEmpty() && tree().findDir(info.navigatePath) > 0;
+        it = m_linkCache.insert(entryIndex, info);
+    }
+    return it.value();
 }
 
 QVector<swcore::FileEntry> FileTableModel::entriesByIndexes(const QSet<int> &indexes) const {
@@ -366,162 +373,155 @@ QVector<swcore::FileEntry> FileTableModel::entriesByIndexes(const QSet<int> &ind
     QVector<swcore::FileEntry> out;
     out.reserve(sorted.size());
     for (int idx : sorted) {
-        out.push_back(m_entries.at(idx));
+        out.push_back(store().entry(idx));
     }
     return out;
 }
 
-void FileTableModel::rebuildSubgroupFiltered() {
-    m_subgroupFilteredIndexes.clear();
-    m_subgroupFilteredIndexes.reserve(m_entries.size());
-    for (int i = 0; i < m_entries.size(); ++i) {
-        const swcore::FileEntry &e = m_entries.at(i);
-        if (m_subgroupRegex.isValid() && !m_subgroupRegex.match(e.subgroup).hasMatch()) {
-            continue;
-        }
-        m_subgroupFilteredIndexes.push_back(i);
+void FileTableModel::scheduleRebuild() {
+    // Abandon whatever is in flight; at most one rebuild runs at a time and
+    // the latest inputs are picked up when it finishes.
+    ++*m_rebuildGeneration;
+    if (m_rebuildWatcher->isRunning()) {
+        m_rebuildQueued = true;
+        return;
     }
+    startRebuild();
 }
 
-void FileTableModel::rebuildRows() {
-    m_rows.clear();
+void FileTableModel::startRebuild() {
+    m_rebuildQueued = false;
+    RebuildRequest request;
+    request.generation = m_rebuildGeneration->load();
+    request.store = m_store;
+    request.index = m_index;
+    request.mask = m_subgroupMask;
+    request.nameFilter = m_nameFilter;
+    request.currentDir = m_requestedDir;
+    request.base = m_snapshot;
+    const std::shared_ptr<const Generation> latest = m_rebuildGeneration;
+    m_rebuildWatcher->setFuture(QtConcurrent::run([request, latest]() { return buildSnapshot(request, latest.get()); }));
+}
 
-    if (canGoUp()) {
-        RowItem up;
-        up.kind = RowKind::Parent;
-        up.relPath = parentOf(m_currentDir);
-        m_rows.push_back(up);
+void FileTableModel::rebuildFinished() {
+    std::shared_ptr<const Snapshot> snapshot = m_rebuildWatcher->result();
+    if (snapshot && snapshot->generation == m_rebuildGeneration->load()) {
+        applySnapshot(std::move(snapshot));
     }
+    if (m_rebuildQueued) {
+        startRebuild();
+    }
+}
 
-    QSet<QString> dirsFromNameMatches;
-    if (!m_nameFilterLower.isEmpty()) {
-        for (int idx : m_subgroupFilteredIndexes) {
-            const CachedEntryPath &path = m_cachedPaths.at(idx);
-            if (!path.baseNameLower.contains(m_nameFilterLower)) {
-                continue;
-            }
-            QString ancestor = path.parentPath;
-            while (!ancestor.isEmpty()) {
-                dirsFromNameMatches.insert(ancestor);
-                ancestor = parentOf(ancestor);
-            }
-        }
+void FileTableModel::applySnapshot(std::shared_ptr<const Snapshot> snapshot) {
+    // Within the same directory and subgroup selection rows keep their slots,
+    // so a filter change is applied as a diff; anything else resets.
+    const bool sameListing = snapshot->view->subgroups == m_snapshot->view->subgroups &&
+                             snapshot->currentDir == m_snapshot->currentDir;
+    if (sameListing) {
+        m_snapshot = std::move(snapshot);
+        applyRows(m_snapshot->rows);
+    } else {
+        beginResetModel();
+        m_snapshot = std::move(snapshot);
+        m_rows = m_snapshot->rows;
+        m_linkCache.clear();
+        endResetModel();
+    }
+    emit viewUpdated();
+}
+
+std::shared_ptr<const FileTableModel::Snapshot> FileTableModel::buildSnapshot(const RebuildRequest &request,
+                                                                            const Generation *latest) {
+    auto stale = [&]() { return latest && latest->load() != request.generation; };
+    const swcore::NameView *baseView = request.base ? request.base->view.get() : nullptr;
+
+    std::shared_ptr<const swcore::SubgroupView> subgroups;
+    if (baseView && baseView->subgroups->store == request.store && baseView->subgroups->mask == request.mask) {
+        subgroups = baseView->subgroups;
+    } else {
+        subgroups = swcore::SubgroupView::build(request.store, request.mask);
+    }
+    if (stale()) {
+        return nullptr;
     }
 
-    QMap<QString, RowItem> dirRows;
-    QVector<RowItem> fileRows;
-    QSet<QString> knownDirs;
+    std::shared_ptr<const swcore::NameView> view;
+    if (baseView && baseView->subgroups == subgroups && baseView->filter == request.nameFilter) {
+        view = request.base->view;
+    } else {
+        view = swcore::NameView::build(
+            subgroups, request.nameFilter, request.index.get(), baseView, latest, request.generation);
+    }
+    if (!view) {
+        return nullptr;
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->generation = request.generation;
+    snapshot->view = std::move(view);
+    snapshot->currentDir = request.currentDir;
+    snapshot->dirId = subgroups->tree.findDir(request.currentDir);
+    snapshot->rows = snapshot->view->rows(snapshot->currentDir, snapshot->dirId);
+    return snapshot;
+}
 
-    for (int idx : m_subgroupFilteredIndexes) {
-        const CachedEntryPath &path = m_cachedPaths.at(idx);
-        if (path.fullPath.isEmpty()) {
+void FileTableModel::applyRows(const QVector<int> &rows) {
+    // Both lists are ordered by slot, so the change is a merge of removed and
+    // inserted runs. Many scattered runs cost more than a reset in the view.
+    constexpr int kMaxRuns = 64;
+    int runs = 0;
+    int i = 0;
+    int j = 0;
+    while (i < m_rows.size() || j < rows.size()) {
+        if (i < m_rows.size() && j < rows.size() && m_rows.at(i) == rows.at(j)) {
+            ++i;
+            ++j;
             continue;
         }
-        QString anc = path.parentPath;
-        while (!anc.isEmpty()) {
-            knownDirs.insert(anc);
-            anc = parentOf(anc);
+        ++runs;
+        while (i < m_rows.size() && (j >= rows.size() || m_rows.at(i) < rows.at(j))) {
+            ++i;
         }
-        if (m_entries.at(idx).ftype == 'd') {
-            knownDirs.insert(path.fullPath);
+        while (j < rows.size() && (i >= m_rows.size() || rows.at(j) < m_rows.at(i))) {
+            ++j;
         }
     }
+    if (runs > kMaxRuns) {
+        beginResetModel();
+        m_rows = rows;
+        endResetModel();
+        return;
+    }
 
-    for (int idx : m_subgroupFilteredIndexes) {
-        const swcore::FileEntry &entry = m_entries.at(idx);
-        const CachedEntryPath &path = m_cachedPaths.at(idx);
-        const QString &fullPath = path.fullPath;
-        if (fullPath.isEmpty()) {
-            continue;
-        }
-
-        const QString &parent = path.parentPath;
-        const QString &base = path.baseName;
-
-        if (parent == m_currentDir) {
-            if (entry.ftype == 'd') {
-                bool show = m_nameFilterLower.isEmpty() || path.baseNameLower.contains(m_nameFilterLower) ||
-                            dirsFromNameMatches.contains(fullPath);
-                if (!show) {
-                    continue;
-                }
-                if (!dirRows.contains(base)) {
-                    RowItem row;
-                    row.kind = RowKind::Directory;
-                    row.name = base;
-                    row.relPath = fullPath;
-                    row.ftype = 'd';
-                    dirRows.insert(base, row);
-                }
-            } else {
-                if (!m_nameFilterLower.isEmpty() && !path.baseNameLower.contains(m_nameFilterLower)) {
-                    continue;
-                }
-                RowItem row;
-                row.kind = RowKind::Entry;
-                row.name = base;
-                row.relPath = fullPath;
-                row.navigatePath = fullPath;
-                row.entryIndex = idx;
-                row.size = entry.size;
-                row.packed = entry.cmpsize;
-                row.payload = entry.payloadSize;
-                row.subgroup = entry.subgroup;
-                row.mach = entry.machExpr;
-                row.offset = entry.offset;
-                row.ftype = entry.ftype;
-                row.linkTarget = entry.symval;
-                if (entry.ftype == 'l') {
-                    const QString resolved = resolveLinkPath(path.parentPath, entry.symval);
-                    if (!resolved.isEmpty()) {
-                        row.navigatePath = resolved;
-                        if (knownDirs.contains(resolved)) {
-                            row.kind = RowKind::DirectoryLink;
-                        }
-                    }
-                }
-                fileRows.push_back(row);
-            }
-            continue;
-        }
-
-        if (!isUnder(fullPath, m_currentDir)) {
+    i = 0;
+    j = 0;
+    while (i < m_rows.size() || j < rows.size()) {
+        if (i < m_rows.size() && j < rows.size() && m_rows.at(i) == rows.at(j)) {
+            ++i;
+            ++j;
             continue;
         }
-
-        QString remainder = fullPath;
-        if (!m_currentDir.isEmpty()) {
-            remainder = fullPath.mid(m_currentDir.size() + 1);
+        int end = i;
+        while (end < m_rows.size() && (j >= rows.size() || m_rows.at(end) < rows.at(j))) {
+            ++end;
         }
-        const int slash = remainder.indexOf('/');
-        if (slash < 0) {
+        if (end > i) {
+            beginRemoveRows(QModelIndex(), i, end - 1);
+            m_rows.remove(i, end - i);
+            endRemoveRows();
             continue;
         }
-
-        const QString childName = remainder.left(slash);
-        const QString childPath = joinPath(m_currentDir, childName);
-        bool show = m_nameFilterLower.isEmpty() || childName.contains(m_nameFilter, Qt::CaseInsensitive) ||
-                    dirsFromNameMatches.contains(childPath);
-        if (!show) {
-            continue;
+        int last = j;
+        while (last < rows.size() && (i >= m_rows.size() || rows.at(last) < m_rows.at(i))) {
+            ++last;
         }
-
-        if (!dirRows.contains(childName)) {
-            RowItem row;
-            row.kind = RowKind::Directory;
-            row.name = childName;
-            row.relPath = childPath;
-            row.ftype = 'd';
-            dirRows.insert(childName, row);
+        beginInsertRows(QModelIndex(), i, i + (last - j) - 1);
+        for (int k = j; k < last; ++k) {
+            m_rows.insert(i + (k - j), rows.at(k));
         }
+        endInsertRows();
+        i += last - j;
+        j = last;
     }
-
-    for (auto it = dirRows.cbegin(); it != dirRows.cend(); ++it) {
-        m_rows.push_back(it.value());
-    }
-
-    std::sort(fileRows.begin(), fileRows.end(), [](const RowItem &a, const RowItem &b) {
-        return QString::compare(a.name, b.name, Qt::CaseInsensitive) < 0;
-    });
-    m_rows += fileRows;
 }
@@ -1,12 +1,19 @@
 #pragma once
 
-#include "swcore/types.h"
+#include "swcore/directory_tree.h"
+#include "swcore/entry_store.h"
+#include "swcore/listing_view.h"
+#include "swcore/path_index.h"
 
 #include <QAbstractTableModel>
+#include <QFutureWatcher>
+#include <QHash>
 #include <QIcon>
-#include <QRegularExpression>
 #include <QSet>
 
+#include <atomic>
+#include <memory>
+
 class FileTableModel : public QAbstractTableModel {
     Q_OBJECT
 public:
@@ -41,50 +48,78 @@ public:
     QVector<swcore::FileEntry> entriesInCurrentTree() const;
     int totalFilteredEntryCount() const;
 
+signals:
+    // A rebuilt view has been swapped in; currentDirectory(), rowCount() and
+    // the counts now describe it.
+    void viewUpdated();
+
 private:
-    struct CachedEntryPath {
-        QString fullPath;
-        QString parentPath;
-        QString baseName;
-        QString baseNameLower;
+    // Rows are slots among the current directory's children: -1 is the
+    // parent row, then come the child directories and the files in tree
+    // order. Display data is derived from the slot on demand, so only rows
+    // the view asks for pay for strings.
+    struct Snapshot {
+        quint64 generation = 0;
+        std::shared_ptr<const swcore::NameView> view;
+        QString currentDir;
+        int dirId = -1;
+        QVector<int> rows;
     };
-
-    struct RowItem {
-        RowKind kind = RowKind::Entry;
-        QString name;
-        QString relPath;
+    struct LinkInfo {
         QString navigatePath;
-        QString linkTarget;
-        int entryIndex = -1;
-        qint64 size = 0;
-        qint64 packed = 0;
-        qint64 payload = 0;
-        QString subgroup;
-        QString mach;
-        qint64 offset = -1;
-        QChar ftype;
+        bool directory = false;
+    };
+    struct RebuildRequest {
+        quint64 generation = 0;
+        std::shared_ptr<const swcore::EntryStore> store;
+        std::shared_ptr<const swcore::PathIndex> index;
+        QString mask;
+        QString nameFilter;
+        QString currentDir;
+        std::shared_ptr<const Snapshot> base;
     };
+    using Generation = std::atomic<quint64>;
 
     static QString normalizedPath(const QString &path);
     static QString parentOf(const QString &path);
-    static QString baseNameOf(const QString &path);
     static QString resolveLinkPath(const QString &baseDir, const QString &target);
-    static bool isUnderOrEqual(const QString &path, const QString &dir);
-    static bool isUnder(const QString &path, const QString &dir);
 
+    // Return null once latest no longer holds the request's generation.
+    static std::shared_ptr<const Snapshot> buildSnapshot(const RebuildRequest &request, const Generation *latest);
+
+    const swcore::EntryStore &store() const { return *m_snapshot->view->subgroups->store; }
+    const swcore::DirectoryTree &tree() const { return m_snapshot->view->subgroups->tree; }
+    // Child directory node or entry index shown at a slot, or -1.
+    int slotDir(int slot) const;
+    int slotEntry(int slot) const;
+    RowKind slotKind(int slot) const;
+    // Resolved on first use and kept until the listing changes.
+    const LinkInfo &linkInfo(int entryIndex) const;
     QVector<swcore::FileEntry> entriesByIndexes(const QSet<int> &indexes) const;
-    void rebuildSubgroupFiltered();
-    void rebuildRows();
-
-    QVector<swcore::FileEntry> m_entries;
-    QVector<CachedEntryPath> m_cachedPaths;
-    QVector<int> m_subgroupFilteredIndexes;
-    QVector<RowItem> m_rows;
-    QString m_currentDir;
+    void buildPathIndex();
+    void scheduleRebuild();
+    void startRebuild();
+    void rebuildFinished();
+    void applySnapshot(std::shared_ptr<const Snapshot> snapshot);
+    void applyRows(const QVector<int> &rows);
+
+    // Latest inputs. The displayed snapshot catches up with them once the
+    // pending rebuild finishes; stale rebuilds are abandoned.
+    std::shared_ptr<const swcore::EntryStore> m_store = std::make_shared<const swcore::EntryStore>();
     QString m_subgroupMask = "*";
     QString m_nameFilter;
-    QString m_nameFilterLower;
-    QRegularExpression m_subgroupRegex{QRegularExpression::wildcardToRegularExpression("*")};
+    QString m_requestedDir;
+    // Built in the background after setEntries(); null until ready.
+    std::shared_ptr<const swcore::PathIndex> m_index;
+    quint64 m_indexGeneration = 0;
+
+    std::shared_ptr<Generation> m_rebuildGeneration = std::make_shared<Generation>(0);
+    QFutureWatcher<std::shared_ptr<const Snapshot>> *m_rebuildWatcher = nullptr;
+    bool m_rebuildQueued = false;
+    std::shared_ptr<const Snapshot> m_snapshot;
+    QVector<int> m_rows;
+    mutable QHash<int, LinkInfo> m_linkCache;
+
     QIcon m_upIcon;
     QIcon m_dirIcon;
     QIcon m_fileIcon;
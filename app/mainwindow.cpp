@@ -1,5 +1,7 @@
 #include "mainwindow.h"
 
+#include "extract_panel.h"
+
 #include "swcore/extractor.h"
 #include "swcore/idb_parser.h"
 
@@ -9,7 +11,6 @@
 #include <QComboBox>
 #include <QCoreApplication>
 #include <QDir>
-#include <QElapsedTimer>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QHeaderView>
@@ -22,7 +23,6 @@
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QModelIndex>
-#include <QProgressDialog>
 #include <QStringList>
 #include <QSize>
 #include <QStatusBar>
@@ -55,6 +55,29 @@ QString appDisplayName() {
     return QString("sw-explorer %1").arg(version);
 }
 
+QString megabytes(qint64 bytes) {
+    return QString::number(bytes / (1024.0 * 1024.0), 'f', 1);
+}
+
+QString extractMetricsText(const swcore::ExtractResult &result) {
+    const double seconds = result.elapsedNs / 1e9;
+    QString text = QString("Read: %1 MB  Written: %2 MB  Time: %3 s")
+                       .arg(megabytes(result.bytesRead), megabytes(result.bytesWritten))
+                       .arg(seconds, 0, 'f', 2);
+    if (seconds > 0) {
+        text += QString("  (%1 MB/s)").arg(megabytes(qint64(result.bytesRead / seconds)));
+    }
+    // Phase times are summed over worker threads.
+    const swcore::ExtractTimings &t = result.timings;
+    text += QString("\nLocate %1 s, read %2 s, decode %3 s, write %4 s, chmod %5 s")
+                .arg(t.locateNs / 1e9, 0, 'f', 2)
+                .arg(t.readNs / 1e9, 0, 'f', 2)
+                .arg(t.decodeNs / 1e9, 0, 'f', 2)
+                .arg(t.writeNs / 1e9, 0, 'f', 2)
+                .arg(t.chmodNs / 1e9, 0, 'f', 2);
+    return text;
+}
+
 } // namespace
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
@@ -74,6 +97,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
             if (!result.error.isEmpty()) {
                 QMessageBox::critical(this, "Scan Error", result.error);
             } else {
+                m_dist = result.dist;
                 m_tableModel->setEntries(result.parsed.entries);
                 updateFilters();
                 if (!result.parsed.warnings.isEmpty()) {
@@ -90,12 +114,24 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
         }
     });
 
+    m_extractWatcher = new QFutureWatcher<swcore::ExtractResult>(this);
+    connect(m_extractWatcher, &QFutureWatcher<swcore::ExtractResult>::finished, this, &MainWindow::extractionFinished);
+
     buildMenus();
     buildUi();
     buildToolBar();
     refreshStatus();
 }
 
+MainWindow::~MainWindow() {
+    // The worker notices within one buffer; wait so it never outlives the
+    // window.
+    if (m_extractProgress) {
+        m_extractProgress->cancel();
+    }
+    m_extractWatcher->waitForFinished();
+}
+
 void MainWindow::buildUi() {
     QWidget *central = new QWidget(this);
     auto *rootLayout = new QVBoxLayout(central);
@@ -106,9 +142,13 @@ void MainWindow::buildUi() {
     m_productCombo->setMinimumWidth(180);
     m_maskEdit = new QLineEdit("*", this);
     m_maskEdit->setMinimumWidth(160);
+    m_maskEdit->setToolTip("Subgroup wildcards separated by commas or spaces.\n"
+                           "Prefix with ! to exclude, e.g. eoe.sw.*, !*.man.*");
     m_searchEdit = new QLineEdit(this);
     m_searchEdit->setMinimumWidth(180);
-    m_searchEdit->setPlaceholderText("Name contains...");
+    m_searchEdit->setPlaceholderText("Name contains, or path/glob...");
+    m_searchEdit->setToolTip("Plain text matches file names.\n"
+                             "Text with '/' or * ? [ ] searches full and source paths.");
 
     auto *pathLayout = new QHBoxLayout();
     auto *upPathButton = new QToolButton(central);
@@ -144,12 +184,19 @@ void MainWindow::buildUi() {
     m_tableView->setColumnWidth(6, 100);
     rootLayout->addWidget(m_tableView, 1);
 
+    m_extractPanel = new ExtractPanel(central);
+    rootLayout->addWidget(m_extractPanel);
+
     setCentralWidget(central);
 
     connect(m_productCombo, &QComboBox::currentTextChanged, this, &MainWindow::scanCurrentProduct);
     connect(m_maskEdit, &QLineEdit::textChanged, this, [this]() { m_filterTimer->start(); });
     connect(m_searchEdit, &QLineEdit::textChanged, this, [this]() { m_filterTimer->start(); });
     connect(m_tableView->selectionModel(), &QItemSelectionModel::selectionChanged, this, &MainWindow::refreshStatus);
+    connect(m_tableModel, &FileTableModel::viewUpdated, this, [this]() {
+        updatePathDisplay();
+        refreshStatus();
+    });
     connect(m_tableView, &QTableView::doubleClicked, this, &MainWindow::activateRow);
     connect(m_tableView, &QTableView::customContextMenuRequested, this, &MainWindow::showTableContextMenu);
 
@@ -339,7 +386,8 @@ void MainWindow::scanCurrentProduct() {
         ScanTaskResult result;
         result.distDir = distDir;
         result.product = product;
-        result.parsed = swcore::IdbParser::parse(distDir, product, &result.error);
+        result.dist = swcore::DistDirectory(distDir);
+        result.parsed = swcore::IdbParser::parseCached(result.dist, product, QString(), &result.error);
         return result;
     });
     m_scanWatcher->setFuture(future);
@@ -347,8 +395,6 @@ void MainWindow::scanCurrentProduct() {
 
 void MainWindow::updateFilters() {
     m_tableModel->setFilters(m_maskEdit->text(), m_searchEdit->text());
-    updatePathDisplay();
-    refreshStatus();
 }
 
 void MainWindow::activateRow(const QModelIndex &index) {
@@ -363,8 +409,6 @@ void MainWindow::activateRow(const QModelIndex &index) {
     }
     if (kind == FileTableModel::RowKind::Directory || kind == FileTableModel::RowKind::DirectoryLink) {
         m_tableModel->setCurrentDirectory(m_tableModel->rowPath(row));
-        updatePathDisplay();
-        refreshStatus();
     }
 }
 
@@ -373,8 +417,6 @@ void MainWindow::goUpDirectory() {
         return;
     }
     m_tableModel->goUp();
-    updatePathDisplay();
-    refreshStatus();
 }
 
 QVector<swcore::FileEntry> MainWindow::selectedEntries() const {
@@ -454,6 +496,9 @@ void MainWindow::extractAll() {
 }
 
 void MainWindow::runExtraction(const QVector<swcore::FileEntry> &entries) {
+    if (m_extractWatcher->isRunning()) {
+        return;
+    }
     if (entries.isEmpty()) {
         QMessageBox::information(this, "Extract", "No entries available.");
         return;
@@ -474,44 +519,25 @@ void MainWindow::runExtraction(const QVector<swcore::FileEntry> &entries) {
     options.noDecompress = m_noDecompressAction->isChecked();
     options.keepZ = m_keepZAction->isChecked();
     options.continueOnError = m_continueOnErrorAction->isChecked();
+    options.workers = 0;
+    options.cachePayloadMaps = true;
+
+    const swcore::DistDirectory dist = m_dist.path() == m_distDirPath ? m_dist : swcore::DistDirectory(m_distDirPath);
+    m_extractProgress = std::make_shared<swcore::ExtractProgress>();
+    const std::shared_ptr<swcore::ExtractProgress> progress = m_extractProgress;
+    setExtractionRunning(true);
+    m_extractPanel->start(progress);
+    m_extractWatcher->setFuture(QtConcurrent::run([dist, entries, outDir, options, progress]() {
+        return swcore::DistExtractor::extract(
+            dist, entries, outDir, options, swcore::DistExtractor::ProgressCallback(), progress.get());
+    }));
+}
 
-    QProgressDialog progress("Extracting...", "Stop", 0, entries.size(), this);
-    progress.setWindowModality(Qt::ApplicationModal);
-    progress.setMinimumDuration(0);
-    progress.setValue(0);
-
-    m_stopRequested = false;
-    m_stopAction->setEnabled(true);
-    QElapsedTimer tick;
-    tick.start();
-    qint64 lastUiUpdateMs = -1;
-
-    const swcore::ExtractResult result =
-        swcore::DistExtractor::extract(m_distDirPath, entries, outDir, options,
-                                       [&](int current, int total, const QString &name) {
-                                           if (progress.wasCanceled() || m_stopRequested) {
-                                               return false;
-                                           }
-
-                                           const qint64 now = tick.elapsed();
-                                           const bool shouldRefreshUi = (current == 1 || current == total || lastUiUpdateMs < 0 ||
-                                                                         (now - lastUiUpdateMs) >= 50);
-                                           if (shouldRefreshUi) {
-                                               lastUiUpdateMs = now;
-                                               progress.setMaximum(total);
-                                               progress.setValue(std::max(0, current - 1));
-                                               progress.setLabelText(
-                                                   QString("Extracting %1 (%2/%3)").arg(name).arg(current).arg(total));
-                                               qApp->processEvents();
-                                               if (progress.wasCanceled() || m_stopRequested) {
-                                                   return false;
-                                               }
-                                           }
-                                           return true;
-                                       });
-
-    m_stopAction->setEnabled(false);
-    progress.setValue(entries.size());
+void MainWindow::extractionFinished() {
+    const swcore::ExtractResult result = m_extractWatcher->result();
+    m_extractPanel->finish();
+    m_extractProgress.reset();
+    setExtractionRunning(false);
 
     QString summary = QString("Total: %1\nExtracted: %2\nSkipped: %3\nErrors: %4")
                           .arg(result.total)
@@ -521,6 +547,7 @@ void MainWindow::runExtraction(const QVector<swcore::FileEntry> &entries) {
     if (result.canceled) {
         summary += "\nCanceled: yes";
     }
+    summary += "\n\n" + extractMetricsText(result);
 
     if (!result.errorMessages.isEmpty()) {
         summary += "\n\nFirst errors:\n";
@@ -538,8 +565,16 @@ void MainWindow::runExtraction(const QVector<swcore::FileEntry> &entries) {
     refreshStatus();
 }
 
+void MainWindow::setExtractionRunning(bool running) {
+    m_extractSelectedAction->setEnabled(!running);
+    m_extractAllAction->setEnabled(!running);
+    m_stopAction->setEnabled(running);
+}
+
 void MainWindow::requestStop() {
-    m_stopRequested = true;
+    if (m_extractProgress) {
+        m_extractProgress->cancel();
+    }
 }
 
 void MainWindow::showAboutDialog() {
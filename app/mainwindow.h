@@ -2,21 +2,28 @@
 
 #include "file_table_model.h"
 
+#include "swcore/dist_directory.h"
+#include "swcore/extractor.h"
+
 #include <QFutureWatcher>
 #include <QMainWindow>
 #include <QPoint>
 
+#include <memory>
+
 class QComboBox;
 class QLineEdit;
 class QTableView;
 class QAction;
 class QModelIndex;
 class QTimer;
+class ExtractPanel;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
 public:
     explicit MainWindow(QWidget *parent = nullptr);
+    ~MainWindow() override;
 
 private slots:
     void openDistDirectory();
@@ -38,6 +45,7 @@ private:
         QString error;
         QString distDir;
         QString product;
+        swcore::DistDirectory dist;
     };
 
     void buildUi();
@@ -47,12 +55,15 @@ private:
     QVector<swcore::FileEntry> selectedEntries() const;
     QString selectedRowPathsText() const;
     void runExtraction(const QVector<swcore::FileEntry> &entries);
+    void extractionFinished();
+    void setExtractionRunning(bool running);
     void updatePathDisplay();
     void refreshStatus();
 
     QString m_distDirPath;
+    // Listing of m_distDirPath taken by the last completed scan.
+    swcore::DistDirectory m_dist;
     QString m_lastOutDirPath;
-    bool m_stopRequested = false;
     bool m_scanQueued = false;
 
     QComboBox *m_productCombo = nullptr;
@@ -75,4 +86,8 @@ private:
     QAction *m_continueOnErrorAction = nullptr;
     QTimer *m_filterTimer = nullptr;
     QFutureWatcher<ScanTaskResult> *m_scanWatcher = nullptr;
+    QFutureWatcher<swcore::ExtractResult> *m_extractWatcher = nullptr;
+    // Shared with the extraction worker while one runs.
+    std::shared_ptr<swcore::ExtractProgress> m_extractProgress;
+    ExtractPanel *m_extractPanel = nullptr;
 };
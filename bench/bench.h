@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QString>
+
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace swbench {
+
+// Work done by one iteration; the runner turns it into MB/s and items/s.
+struct Counters {
+    qint64 bytes = 0;
+    qint64 items = 0;
+};
+
+using BenchFn = std::function<void(Counters *counters)>;
+
+struct BenchCase {
+    QString name;
+    BenchFn fn;
+};
+
+std::vector<BenchCase> &registry();
+
+struct Registrar {
+    Registrar(const QString &name, BenchFn fn) {
+        registry().push_back({name, std::move(fn)});
+    }
+};
+
+// Keeps the optimizer from discarding a computed result.
+void doNotOptimize(const void *p);
+
+} // namespace swbench
+
+#define SWBENCH_CONCAT_IMPL(a, b) a##b
+#define SWBENCH_CONCAT(a, b) SWBENCH_CONCAT_IMPL(a, b)
+#define SWBENCH(name, fn) static const swbench::Registrar SWBENCH_CONCAT(swbenchRegistrar, __LINE__)(name, fn)
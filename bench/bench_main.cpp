@@ -0,0 +1,98 @@
+#include "bench.h"
+
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const void *volatile g_sink = nullptr;
+
+} // namespace
+
+namespace swbench {
+
+std::vector<BenchCase> &registry() {
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+void doNotOptimize(const void *p) {
+    g_sink = p;
+}
+
+} // namespace swbench
+
+namespace {
+
+void printUsage() {
+    std::printf("usage: swcore_bench [--list] [--min-time=SECONDS] [FILTER...]\n"
+                "Runs every benchmark whose name contains one of the FILTER substrings.\n");
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    double minTime = 1.0;
+    bool listOnly = false;
+    QStringList filters;
+    for (int i = 1; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        }
+        if (arg == "--list") {
+            listOnly = true;
+        } else if (arg.startsWith("--min-time=")) {
+            minTime = arg.mid(int(std::strlen("--min-time="))).toDouble();
+        } else {
+            filters.push_back(arg);
+        }
+    }
+
+    std::printf("%-40s %8s %12s %12s %14s\n", "benchmark", "iters", "ms/iter", "MB/s", "items/s");
+    for (const swbench::BenchCase &bench : swbench::registry()) {
+        bool selected = filters.isEmpty();
+        for (const QString &f : filters) {
+            if (bench.name.contains(f)) {
+                selected = true;
+                break;
+            }
+        }
+        if (!selected) {
+            continue;
+        }
+        if (listOnly) {
+            std::printf("%s\n", qPrintable(bench.name));
+            continue;
+        }
+
+        swbench::Counters warmup;
+        bench.fn(&warmup);
+
+        swbench::Counters total;
+        qint64 iters = 0;
+        QElapsedTimer timer;
+        timer.start();
+        while (iters < 3 || timer.nsecsElapsed() < qint64(minTime * 1e9)) {
+            bench.fn(&total);
+            ++iters;
+        }
+        const double secs = double(timer.nsecsElapsed()) / 1e9;
+
+        const double msPerIter = secs * 1e3 / double(iters);
+        const double mbps = total.bytes > 0 ? double(total.bytes) / (1024.0 * 1024.0) / secs : 0.0;
+        const double itemsps = total.items > 0 ? double(total.items) / secs : 0.0;
+        std::printf("%-40s %8lld %12.3f %12.1f %14.0f\n",
+                    qPrintable(bench.name),
+                    static_cast<long long>(iters),
+                    msPerIter,
+                    mbps,
+                    itemsps);
+        std::fflush(stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "bench.h"
+#include "synthetic_dist.h"
+
+#include "swcore/extractor.h"
+
+#include <QDir>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+struct ExtractFixture {
+    const swbench::ParsedDist &dist;
+    QString outDir;
+    QString mapDir;
+};
+
+ExtractFixture makeFixture(const swbench::SyntheticDistOptions &options) {
+    const swbench::ParsedDist &dist = swbench::parsedSyntheticDist(options);
+    const QDir work(dist.workDir);
+    return {dist, work.filePath("out"), work.filePath("maps")};
+}
+
+// ~40 MB of text in 1-16 KiB files; iterations overwrite the same tree.
+const ExtractFixture &plainFixture() {
+    static const ExtractFixture fixture = [] {
+        swbench::SyntheticDistOptions options;
+        options.files = 5000;
+        options.minFileBytes = 1024;
+        options.maxFileBytes = 16 * 1024;
+        return makeFixture(options);
+    }();
+    return fixture;
+}
+
+// Same shape with junk before every 64th payload, so locating pays for a
+// resync scan each time.
+const ExtractFixture &driftFixture() {
+    static const ExtractFixture fixture = [] {
+        swbench::SyntheticDistOptions options;
+        options.files = 5000;
+        options.minFileBytes = 1024;
+        options.maxFileBytes = 16 * 1024;
+        options.driftEvery = 64;
+        options.driftBytes = 64 * 1024;
+        return makeFixture(options);
+    }();
+    return fixture;
+}
+
+// Without the map cache every run walks the subproduct files again.
+void runExtract(const ExtractFixture &f, int workers, bool cacheMaps, swbench::Counters *counters) {
+    swcore::ExtractOptions options;
+    options.workers = workers;
+    options.cachePayloadMaps = cacheMaps;
+    options.payloadMapDir = f.mapDir;
+    const swcore::ExtractResult result =
+        swcore::DistExtractor::extract(f.dist.distDir, f.dist.parsed.entries, f.outDir, options);
+    if (result.errors > 0 || result.extracted + result.skipped != f.dist.dist.entries) {
+        std::fprintf(stderr,
+                     "Extract failed (%d errors): %s\n",
+                     result.errors,
+                     qPrintable(result.errorMessages.value(0)));
+        std::abort();
+    }
+    counters->bytes += f.dist.dist.rawBytes;
+    counters->items += f.dist.dist.entries;
+}
+
+} // namespace
+
+SWBENCH("extract/serial", [](swbench::Counters *c) { runExtract(plainFixture(), 1, false, c); });
+SWBENCH("extract/parallel", [](swbench::Counters *c) { runExtract(plainFixture(), 0, false, c); });
+SWBENCH("extract/drift", [](swbench::Counters *c) { runExtract(driftFixture(), 1, false, c); });
+SWBENCH("extract/drift/cached-map", [](swbench::Counters *c) { runExtract(driftFixture(), 1, true, c); });
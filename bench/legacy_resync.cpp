@@ -0,0 +1,67 @@
+// Verbatim copy of the original indexOf-per-variant resyncOffset() from
+// core/src/payload_scan.cpp, kept as the baseline for the resync benchmarks.
+
+#include "legacy_resync.h"
+
+#include "swcore/payload_scan.h"
+#include "swcore/subproduct_file.h"
+
+#include <algorithm>
+
+namespace swbench {
+
+std::optional<QPair<qint64, QByteArray>> legacyResyncOffset(swcore::SubproductFile &file,
+                                                             const QList<QByteArray> &variants,
+                                                             qint64 baseOffset,
+                                                             qint64 back,
+                                                             qint64 forward,
+                                                             qint64 chunkSize) {
+    if (variants.isEmpty()) {
+        return std::nullopt;
+    }
+
+    const qint64 scanStart = std::max<qint64>(0, baseOffset - back);
+    const qint64 scanEnd = std::min(file.size(), baseOffset + forward);
+    if (scanStart >= scanEnd) {
+        return std::nullopt;
+    }
+
+    int maxNameLen = 0;
+    for (const QByteArray &v : variants) {
+        maxNameLen = std::max(maxNameLen, int(v.size()));
+    }
+    const qint64 overlap = maxNameLen + 2;
+    // A mapped file is scanned as one window; otherwise read it in chunks.
+    if (file.isMapped()) {
+        chunkSize = scanEnd - scanStart;
+    }
+    qint64 pos = scanStart;
+
+    while (pos < scanEnd) {
+        const qint64 toRead = std::min(chunkSize, scanEnd - pos);
+        const QByteArray blob = file.bytes(pos, toRead);
+        if (blob.isEmpty()) {
+            break;
+        }
+
+        // Candidates are validated against the bytes already in the blob.
+        for (const QByteArray &name : variants) {
+            int found = blob.indexOf(name);
+            while (found >= 0) {
+                if (found >= 2 && swcore::headerMatches(blob.constData() + found - 2, name)) {
+                    return QPair<qint64, QByteArray>(pos + found - 2, name);
+                }
+                found = blob.indexOf(name, found + 1);
+            }
+        }
+
+        if (toRead <= overlap) {
+            break;
+        }
+        pos += toRead - overlap;
+    }
+
+    return std::nullopt;
+}
+
+} // namespace swbench
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+
+#include <optional>
+
+namespace swcore {
+class SubproductFile;
+}
+
+namespace swbench {
+
+std::optional<QPair<qint64, QByteArray>> legacyResyncOffset(swcore::SubproductFile &file,
+                                                             const QList<QByteArray> &variants,
+                                                             qint64 baseOffset,
+                                                             qint64 back,
+                                                             qint64 forward,
+                                                             qint64 chunkSize);
+
+} // namespace swbench
@@ -0,0 +1,208 @@
+// Verbatim copy of the original CompressCodeReader/unlzw decoder from
+// core/src/extractor.cpp, kept as the baseline for the LZW benchmarks.
+
+#include "legacy_unlzw.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace swbench {
+
+namespace {
+
+class CompressCodeReader {
+public:
+    explicit CompressCodeReader(QByteArray data) : m_data(std::move(data)) {}
+
+    int nextCode(int maxBits, int maxMaxCode, int *nBits, int *maxCode, int freeEnt, bool *clearFlag) {
+        if (!nBits || !maxCode || !clearFlag) {
+            return -1;
+        }
+
+        if (*clearFlag || m_offset >= m_size || freeEnt > *maxCode) {
+            if (freeEnt > *maxCode) {
+                ++(*nBits);
+                if (*nBits == maxBits) {
+                    *maxCode = maxMaxCode;
+                } else {
+                    *maxCode = (1 << *nBits) - 1;
+                }
+            }
+
+            if (*clearFlag) {
+                *nBits = 9;
+                *maxCode = (1 << *nBits) - 1;
+                *clearFlag = false;
+            }
+
+            const int remain = m_data.size() - m_pos;
+            if (remain <= 0) {
+                return -1;
+            }
+
+            const int chunkBytes = std::min(*nBits, remain);
+            m_chunk = m_data.mid(m_pos, chunkBytes);
+            m_pos += chunkBytes;
+
+            m_offset = 0;
+            m_size = (chunkBytes << 3) - (*nBits - 1);
+            if (m_size <= 0) {
+                return -1;
+            }
+        }
+
+        if (m_offset >= m_size) {
+            return -1;
+        }
+
+        const int startBit = m_offset;
+        const int endBit = startBit + *nBits - 1;
+        const int endByte = endBit >> 3;
+        if (endByte >= m_chunk.size()) {
+            return -1;
+        }
+
+        static constexpr quint32 rmask[9] = {
+            0x00, 0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F, 0xFF
+        };
+
+        int bitOffset = startBit & 7;
+        int bitsLeft = *nBits;
+        const uchar *bp = reinterpret_cast<const uchar *>(m_chunk.constData()) + (startBit >> 3);
+
+        quint32 code = quint32(*bp++ >> bitOffset);
+        bitsLeft -= 8 - bitOffset;
+        int shift = 8 - bitOffset;
+
+        while (bitsLeft >= 8) {
+            code |= quint32(*bp++) << shift;
+            shift += 8;
+            bitsLeft -= 8;
+        }
+
+        if (bitsLeft > 0) {
+            code |= (quint32(*bp) & rmask[bitsLeft]) << shift;
+        }
+
+        m_offset += *nBits;
+        return int(code);
+    }
+
+private:
+    QByteArray m_data;
+    int m_pos = 0;
+    QByteArray m_chunk;
+    int m_offset = 0;
+    int m_size = 0;
+};
+
+} // namespace
+
+QByteArray legacyUnlzw(const QByteArray &input) {
+    if (input.size() < 3 || quint8(input.at(0)) != 0x1F || quint8(input.at(1)) != 0x9D) {
+        throw std::runtime_error("Not a .Z stream");
+    }
+
+    const int flags = quint8(input.at(2));
+    const int maxbits = flags & 0x1F;
+    const bool blockMode = (flags & 0x80) != 0;
+    if (maxbits < 9 || maxbits > 16) {
+        throw std::runtime_error("Unsupported .Z maxbits");
+    }
+
+    const int clearCode = 256;
+    const int firstCode = 257;
+    const int maxMaxCode = 1 << maxbits;
+
+    int nBits = 9;
+    int maxCode = (1 << nBits) - 1;
+    int freeEnt = blockMode ? firstCode : 256;
+    bool clearFlag = false;
+
+    CompressCodeReader reader(input.mid(3));
+
+    std::vector<int> prefix(maxMaxCode, 0);
+    std::vector<quint8> suffix(maxMaxCode, 0);
+    std::vector<quint8> stack(maxMaxCode, 0);
+    for (int i = 0; i < 256; ++i) {
+        suffix[i] = quint8(i);
+    }
+
+    QByteArray output;
+
+    int oldCode = -1;
+    quint8 finChar = 0;
+
+    while (true) {
+        int code = reader.nextCode(maxbits, maxMaxCode, &nBits, &maxCode, freeEnt, &clearFlag);
+        if (code < 0) {
+            break;
+        }
+
+        if (blockMode && code == clearCode) {
+            clearFlag = true;
+            freeEnt = firstCode;
+            oldCode = -1;
+            continue;
+        }
+
+        if (oldCode < 0) {
+            if (code > 255) {
+                throw std::runtime_error("Corrupt .Z stream");
+            }
+            finChar = quint8(code);
+            output.append(char(finChar));
+            oldCode = code;
+            continue;
+        }
+
+        const int inCode = code;
+        int stackTop = 0;
+
+        if (code >= freeEnt) {
+            if (code != freeEnt) {
+                throw std::runtime_error("LZW decode error");
+            }
+            if (stackTop >= int(stack.size())) {
+                throw std::runtime_error("LZW stack overflow");
+            }
+            stack[stackTop++] = finChar;
+            code = oldCode;
+        }
+
+        while (code >= 256) {
+            if (code >= freeEnt || code < 0) {
+                throw std::runtime_error("LZW decode error");
+            }
+            if (stackTop >= int(stack.size())) {
+                throw std::runtime_error("LZW stack overflow");
+            }
+            stack[stackTop++] = suffix[code];
+            code = prefix[code];
+        }
+
+        finChar = quint8(code & 0xFF);
+        if (stackTop >= int(stack.size())) {
+            throw std::runtime_error("LZW stack overflow");
+        }
+        stack[stackTop++] = finChar;
+
+        while (stackTop > 0) {
+            output.append(char(stack[--stackTop]));
+        }
+
+        if (freeEnt < maxMaxCode) {
+            prefix[freeEnt] = oldCode;
+            suffix[freeEnt] = finChar;
+            ++freeEnt;
+        }
+
+        oldCode = inCode;
+    }
+
+    return output;
+}
+
+} // namespace swbench
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <QByteArray>
+
+namespace swbench {
+
+QByteArray legacyUnlzw(const QByteArray &input);
+
+} // namespace swbench
@@ -0,0 +1,91 @@
+#include "bench.h"
+#include "legacy_unlzw.h"
+#include "lzw_compress.h"
+
+#include "swcore/lzw.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+
+namespace {
+
+constexpr int kCorpusSize = 8 * 1024 * 1024;
+
+// Word soup resembling man pages and scripts; compresses roughly 3:1.
+QByteArray textCorpus() {
+    static const char *const words[] = {
+        "the", "file", "system", "IRIX", "inst", "usr", "lib", "share", "man", "for",
+        "if", "then", "else", "fi", "echo", "return", "include", "define", "struct", "int",
+        "char", "static", "void", "0x1f9d", "/usr/lib32", "mips", "SGI", "license", "=", "{",
+    };
+    std::mt19937 rng(20261016);
+    QByteArray out;
+    out.reserve(kCorpusSize + 32);
+    while (out.size() < kCorpusSize) {
+        out.append(words[rng() % (sizeof(words) / sizeof(words[0]))]);
+        out.append(rng() % 11 == 0 ? '\n' : ' ');
+    }
+    out.resize(kCorpusSize);
+    return out;
+}
+
+// Object-code-like bytes: short repeated opcodes mixed with noise.
+QByteArray binaryCorpus() {
+    std::mt19937 rng(4242);
+    QByteArray out;
+    out.resize(kCorpusSize);
+    char *p = out.data();
+    for (int i = 0; i < kCorpusSize; ++i) {
+        const quint32 r = rng();
+        p[i] = (r & 3) == 0 ? char(r >> 8) : char("\x27\xbd\xff\xe0\x8f\xbf\x00\x1c"[(i + (r >> 4)) & 7]);
+    }
+    return out;
+}
+
+struct Corpus {
+    QByteArray raw;
+    QByteArray packed;
+};
+
+Corpus makeCorpus(QByteArray raw) {
+    Corpus c;
+    c.raw = std::move(raw);
+    c.packed = swbench::lzwCompress(c.raw);
+    if (swcore::unlzw(c.packed) != c.raw || swbench::legacyUnlzw(c.packed) != c.raw) {
+        std::fprintf(stderr, "LZW round trip mismatch\n");
+        std::abort();
+    }
+    return c;
+}
+
+const Corpus &corpus(bool text) {
+    if (text) {
+        static const Corpus c = makeCorpus(textCorpus());
+        return c;
+    }
+    static const Corpus c = makeCorpus(binaryCorpus());
+    return c;
+}
+
+void runLegacy(bool text, swbench::Counters *counters) {
+    const Corpus &c = corpus(text);
+    const QByteArray out = swbench::legacyUnlzw(c.packed);
+    swbench::doNotOptimize(out.constData());
+    counters->bytes += out.size();
+}
+
+void runTable(bool text, swbench::Counters *counters) {
+    const Corpus &c = corpus(text);
+    const QByteArray out = swcore::unlzw(c.packed, c.raw.size());
+    swbench::doNotOptimize(out.constData());
+    counters->bytes += out.size();
+}
+
+} // namespace
+
+SWBENCH("lzw/legacy/text", [](swbench::Counters *c) { runLegacy(true, c); });
+SWBENCH("lzw/table/text", [](swbench::Counters *c) { runTable(true, c); });
+SWBENCH("lzw/legacy/binary", [](swbench::Counters *c) { runLegacy(false, c); });
+SWBENCH("lzw/table/binary", [](swbench::Counters *c) { runTable(false, c); });
@@ -0,0 +1,131 @@
+#include "lzw_compress.h"
+
+#include <QtGlobal>
+
+#include <unordered_map>
+
+namespace swbench {
+
+namespace {
+
+constexpr int kInitBits = 9;
+constexpr int kClearCode = 256;
+constexpr int kFirstCode = 257;
+
+class BitWriter {
+public:
+    explicit BitWriter(QByteArray *out) : m_out(out) {}
+
+    void write(quint32 code, int nBits) {
+        m_acc |= quint64(code) << m_accBits;
+        m_accBits += nBits;
+        m_bitCount += nBits;
+        while (m_accBits >= 8) {
+            m_out->append(char(m_acc & 0xFF));
+            m_acc >>= 8;
+            m_accBits -= 8;
+        }
+    }
+
+    // Pads to the end of the current group of nBits bytes, as ncompress does
+    // before switching code width or after a CLEAR.
+    void padToGroup(int nBits) {
+        const qint64 groupBits = qint64(nBits) * 8;
+        qint64 pad = (groupBits - (m_bitCount - m_groupStart) % groupBits) % groupBits;
+        while (pad > 0) {
+            const int n = int(qMin<qint64>(pad, 16));
+            write(0, n);
+            pad -= n;
+        }
+        m_groupStart = m_bitCount;
+    }
+
+    void finish() {
+        if (m_accBits > 0) {
+            m_out->append(char(m_acc & 0xFF));
+            m_acc = 0;
+            m_accBits = 0;
+        }
+    }
+
+private:
+    QByteArray *m_out = nullptr;
+    quint64 m_acc = 0;
+    int m_accBits = 0;
+    qint64 m_bitCount = 0;
+    qint64 m_groupStart = 0;
+};
+
+} // namespace
+
+QByteArray lzwCompress(const QByteArray &input, int maxBits) {
+    maxBits = qBound(kInitBits, maxBits, 16);
+    const int maxMaxCode = 1 << maxBits;
+
+    QByteArray out;
+    out.reserve(input.size() / 2 + 16);
+    out.append(char(0x1F));
+    out.append(char(0x9D));
+    out.append(char(0x80 | maxBits));
+    if (input.isEmpty()) {
+        return out;
+    }
+
+    BitWriter writer(&out);
+    std::unordered_map<quint32, int> dict;
+    dict.reserve(size_t(maxMaxCode));
+
+    int nBits = kInitBits;
+    int maxCode = (1 << nBits) - 1;
+    // Mirrors the decoder's free_ent, which lags one entry behind ours.
+    int decoderFreeEnt = kFirstCode;
+    bool firstSinceClear = true;
+    int nextCode = kFirstCode;
+
+    auto emit = [&](int code) {
+        if (decoderFreeEnt > maxCode) {
+            writer.padToGroup(nBits);
+            ++nBits;
+            maxCode = nBits == maxBits ? maxMaxCode : (1 << nBits) - 1;
+        }
+        writer.write(quint32(code), nBits);
+        if (code == kClearCode) {
+            writer.padToGroup(nBits);
+            nBits = kInitBits;
+            maxCode = (1 << nBits) - 1;
+            decoderFreeEnt = kFirstCode;
+            firstSinceClear = true;
+            return;
+        }
+        if (!firstSinceClear && decoderFreeEnt < maxMaxCode) {
+            ++decoderFreeEnt;
+        }
+        firstSinceClear = false;
+    };
+
+    int prefix = quint8(input.at(0));
+    for (int i = 1; i < input.size(); ++i) {
+        const quint8 c = quint8(input.at(i));
+        const quint32 key = (quint32(prefix) << 8) | c;
+        const auto it = dict.find(key);
+        if (it != dict.end()) {
+            prefix = it->second;
+            continue;
+        }
+
+        emit(prefix);
+        if (nextCode < maxMaxCode) {
+            dict.emplace(key, nextCode++);
+        } else {
+            emit(kClearCode);
+            dict.clear();
+            nextCode = kFirstCode;
+        }
+        prefix = c;
+    }
+    emit(prefix);
+    writer.finish();
+    return out;
+}
+
+} // namespace swbench
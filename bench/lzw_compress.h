@@ -0,0 +1,11 @@
+#pragma once
+
+#include <QByteArray>
+
+namespace swbench {
+
+// Block-mode Unix compress encoder producing ncompress-compatible .Z streams.
+// The dictionary is cleared whenever it fills up.
+QByteArray lzwCompress(const QByteArray &input, int maxBits = 16);
+
+} // namespace swbench
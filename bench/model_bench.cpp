@@ -0,0 +1,62 @@
+#include "bench.h"
+#include "synthetic_dist.h"
+
+#include "swcore/entry_store.h"
+#include "swcore/listing_view.h"
+#include "swcore/path_index.h"
+
+#include <memory>
+
+namespace {
+
+// The levels FileTableModel rebuilds through on a filter change: subgroup
+// selection and tree, name or path filter, and the rows of one listing.
+struct ModelFixture {
+    std::shared_ptr<const swcore::EntryStore> store;
+    std::unique_ptr<swcore::PathIndex> index;
+};
+
+const ModelFixture &modelFixture() {
+    static const ModelFixture fixture = [] {
+        swbench::SyntheticDistOptions options;
+        options.files = 60000;
+        options.minFileBytes = 16;
+        options.maxFileBytes = 64;
+        ModelFixture f;
+        f.store = std::make_shared<const swcore::EntryStore>(swbench::parsedSyntheticDist(options).parsed.entries);
+        f.index = std::make_unique<swcore::PathIndex>(*f.store);
+        return f;
+    }();
+    return fixture;
+}
+
+int rebuild(const QString &mask, const QString &filter, bool useIndex) {
+    const ModelFixture &f = modelFixture();
+    const auto subgroups = swcore::SubgroupView::build(f.store, mask);
+    const auto view =
+        swcore::NameView::build(subgroups, filter, useIndex ? f.index.get() : nullptr, nullptr, nullptr, 0);
+
+    // Rows of the deepest directory on the first path, as the view would
+    // list after navigating there.
+    const swcore::DirectoryTree &tree = subgroups->tree;
+    int dirId = tree.root();
+    while (dirId >= 0 && !tree.node(dirId).dirs.empty()) {
+        dirId = tree.node(dirId).dirs.front();
+    }
+    const QVector<int> rows = view->rows(dirId >= 0 ? tree.node(dirId).path : QString(), dirId);
+    swbench::doNotOptimize(rows.constData());
+    return subgroups->indexes.size();
+}
+
+void runRebuild(const QString &mask, const QString &filter, bool useIndex, swbench::Counters *counters) {
+    counters->items += rebuild(mask, filter, useIndex);
+}
+
+} // namespace
+
+SWBENCH("model/rebuild/all", [](swbench::Counters *c) { runRebuild("*", QString(), false, c); });
+SWBENCH("model/rebuild/mask", [](swbench::Counters *c) { runRebuild("synth.sw.*, !*.lib", QString(), false, c); });
+SWBENCH("model/rebuild/name", [](swbench::Counters *c) { runRebuild("*", "file12", false, c); });
+SWBENCH("model/rebuild/path-scan", [](swbench::Counters *c) { runRebuild("*", "d03/d05/", false, c); });
+SWBENCH("model/rebuild/path-index", [](swbench::Counters *c) { runRebuild("*", "d03/d05/", true, c); });
+SWBENCH("model/rebuild/glob", [](swbench::Counters *c) { runRebuild("*", "*/d05/*file1*", true, c); });
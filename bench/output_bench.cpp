@@ -0,0 +1,101 @@
+#include "bench.h"
+
+#include "swcore/output_tree.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileDevice>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+constexpr int kDepth = 10;
+constexpr int kFanout = 4;
+constexpr int kFilesPerDir = 8;
+constexpr int kFiles = 8192;
+
+// kFiles small files, kFilesPerDir to a leaf directory kDepth levels down.
+const QStringList &deepPaths() {
+    static const QStringList paths = [] {
+        QStringList out;
+        out.reserve(kFiles);
+        for (int i = 0; i < kFiles; ++i) {
+            QString path;
+            int dir = i / kFilesPerDir;
+            for (int level = 0; level < kDepth; ++level) {
+                path += QString("d%1_%2/").arg(level).arg(dir % kFanout);
+                dir /= kFanout;
+            }
+            out.push_back(path + QString("file%1.dat").arg(i));
+        }
+        return out;
+    }();
+    return paths;
+}
+
+const QByteArray &content() {
+    static const QByteArray bytes(256, 'x');
+    return bytes;
+}
+
+// Every iteration writes a fresh tree, so directory creation is measured
+// along with the files.
+QString freshRoot() {
+    static QTemporaryDir tmp;
+    static int run = 0;
+    if (!tmp.isValid()) {
+        std::fprintf(stderr, "Cannot create temporary directory\n");
+        std::abort();
+    }
+    return tmp.filePath(QString("run%1").arg(run++));
+}
+
+void fail(const QString &path) {
+    std::fprintf(stderr, "Cannot write %s\n", qPrintable(path));
+    std::abort();
+}
+
+// What extraction did per file before OutputTree: mkpath of the parent,
+// a stat of the target, QSaveFile and a chmod by path.
+void writeWithMkpath(swbench::Counters *counters) {
+    const QDir root(freshRoot());
+    const QFileDevice::Permissions perms =
+        QFileDevice::ReadOwner | QFileDevice::WriteOwner | QFileDevice::ReadGroup | QFileDevice::ReadOther;
+    for (const QString &rel : deepPaths()) {
+        const QString path = root.filePath(rel);
+        if (!QDir().mkpath(QFileInfo(path).path()) || QFileInfo(path).isDir()) {
+            fail(path);
+        }
+        QSaveFile out(path);
+        if (!out.open(QIODevice::WriteOnly) || out.write(content()) != content().size() || !out.commit()) {
+            fail(path);
+        }
+        QFile(path).setPermissions(perms);
+    }
+    counters->bytes += qint64(kFiles) * content().size();
+    counters->items += kFiles;
+}
+
+void writeWithTree(swbench::Counters *counters) {
+    swcore::OutputTree tree(freshRoot());
+    for (const QString &rel : deepPaths()) {
+        swcore::OutputFile out(&tree, rel);
+        if (!out.open(nullptr) || !out.write(content().constData(), content().size()) || !out.setMode(0644) ||
+            !out.commit()) {
+            fail(out.fileName());
+        }
+    }
+    counters->bytes += qint64(kFiles) * content().size();
+    counters->items += kFiles;
+}
+
+} // namespace
+
+SWBENCH("output/deep/mkpath", writeWithMkpath);
+SWBENCH("output/deep/tree", writeWithTree);
@@ -0,0 +1,35 @@
+#include "bench.h"
+#include "synthetic_dist.h"
+
+#include "swcore/idb_parser.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+// Many tiny payloads so the run is dominated by the idb text (~8 MB).
+const swbench::SyntheticDist &parseDist() {
+    swbench::SyntheticDistOptions options;
+    options.files = 60000;
+    options.minFileBytes = 16;
+    options.maxFileBytes = 64;
+    return swbench::parsedSyntheticDist(options).dist;
+}
+
+void runParse(swbench::Counters *counters) {
+    const swbench::SyntheticDist &dist = parseDist();
+    QString error;
+    const swcore::ParseResult result = swcore::IdbParser::parse(dist.dir, dist.product, &error);
+    if (!error.isEmpty() || result.entries.size() != dist.entries) {
+        std::fprintf(stderr, "Parse failed: %s\n", qPrintable(error));
+        std::abort();
+    }
+    swbench::doNotOptimize(result.entries.constData());
+    counters->bytes += dist.idbBytes;
+    counters->items += result.entries.size();
+}
+
+} // namespace
+
+SWBENCH("idb/parse", runParse);
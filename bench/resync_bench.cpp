@@ -0,0 +1,118 @@
+#include "bench.h"
+#include "legacy_resync.h"
+
+#include "swcore/payload_scan.h"
+#include "swcore/subproduct_file.h"
+
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+
+namespace {
+
+// The full default resyncForward window.
+constexpr int kScanBytes = 16 * 1024 * 1024;
+
+const QByteArray &targetName() {
+    static const QByteArray name("usr/share/synth/d07/d03/file99999.txt");
+    return name;
+}
+
+// Path-like text without headers.
+QByteArray textFiller() {
+    static const char *const words[] = {
+        "usr/share/synth/", "d07/", "file", ".txt", "lib", "the", "IRIX", "inst", "man", "\n",
+    };
+    std::mt19937 rng(7);
+    QByteArray data;
+    data.reserve(kScanBytes + 64);
+    while (data.size() < kScanBytes) {
+        data.append(words[rng() % (sizeof(words) / sizeof(words[0]))]);
+    }
+    return data;
+}
+
+// Worst-case drift: back-to-back headers for every variant of the wanted name
+// with one byte changed, so length prefix, first and last byte all match and
+// every record has to be compared in full.
+QByteArray nearMissFiller() {
+    const QByteArray &name = targetName();
+    const QByteArray variants[] = {name, "./" + name, "/" + name};
+    std::mt19937 rng(11);
+    QByteArray data;
+    data.reserve(kScanBytes + 64);
+    while (data.size() < kScanBytes) {
+        QByteArray miss = variants[rng() % 3];
+        miss[1 + int(rng() % quint32(miss.size() - 2))] = 'X';
+        data.append(char((miss.size() >> 8) & 0xFF));
+        data.append(char(miss.size() & 0xFF));
+        data.append(miss);
+    }
+    return data;
+}
+
+// A subproduct whose only real header sits at the very end of the window, so
+// every scan covers all of it.
+struct ScanFile {
+    QTemporaryDir tmp;
+    std::unique_ptr<swcore::SubproductFile> file;
+    QList<QByteArray> variants;
+};
+
+std::unique_ptr<ScanFile> makeScanFile(QByteArray data) {
+    auto s = std::make_unique<ScanFile>();
+    data.replace(0, 13, "synth-subprod");
+    data.resize(kScanBytes);
+    const QByteArray &name = targetName();
+    data.append(char((name.size() >> 8) & 0xFF));
+    data.append(char(name.size() & 0xFF));
+    data.append(name);
+
+    QFile out(s->tmp.filePath("synth.sw"));
+    if (!s->tmp.isValid() || !out.open(QIODevice::WriteOnly) || out.write(data) != data.size()) {
+        std::fprintf(stderr, "Cannot write resync corpus\n");
+        std::abort();
+    }
+    out.close();
+    s->file = std::make_unique<swcore::SubproductFile>(out.fileName());
+    if (!s->file->open()) {
+        std::fprintf(stderr, "Cannot open resync corpus\n");
+        std::abort();
+    }
+    s->variants << name << ("./" + name) << ("/" + name);
+    return s;
+}
+
+const ScanFile &scanFile(bool worst) {
+    if (worst) {
+        static const std::unique_ptr<ScanFile> s = makeScanFile(nearMissFiller());
+        return *s;
+    }
+    static const std::unique_ptr<ScanFile> s = makeScanFile(textFiller());
+    return *s;
+}
+
+void runScan(bool legacy, bool worst, swbench::Counters *counters) {
+    const ScanFile &scan = scanFile(worst);
+    const qint64 size = scan.file->size();
+    constexpr qint64 kChunk = 1024 * 1024;
+    const auto found = legacy ? swbench::legacyResyncOffset(*scan.file, scan.variants, 0, 0, size, kChunk)
+                              : swcore::resyncOffset(*scan.file, scan.variants, 0, 0, size, kChunk);
+    if (!found || found->first != kScanBytes) {
+        std::fprintf(stderr, "Resync scan missed the header\n");
+        std::abort();
+    }
+    counters->bytes += size;
+    counters->items += 1;
+}
+
+} // namespace
+
+SWBENCH("resync/legacy/text", [](swbench::Counters *c) { runScan(true, false, c); });
+SWBENCH("resync/vector/text", [](swbench::Counters *c) { runScan(false, false, c); });
+SWBENCH("resync/legacy/worst", [](swbench::Counters *c) { runScan(true, true, c); });
+SWBENCH("resync/vector/worst", [](swbench::Counters *c) { runScan(false, true, c); });
@@ -0,0 +1,207 @@
+#include "synthetic_dist.h"
+
+#include "lzw_compress.h"
+
+#include "swcore/idb_parser.h"
+
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace swbench {
+
+namespace {
+
+// Subproduct files start with a fixed-size header that the idb offsets skip.
+constexpr char kSubproductHeader[] = "synth-subprod";
+static_assert(sizeof(kSubproductHeader) - 1 == 13, "subproduct header is 13 bytes");
+
+QByteArray fileContent(std::mt19937 *rng, int size) {
+    static const char *const words[] = {
+        "the", "file", "system", "IRIX", "inst", "usr", "lib", "share", "man", "for",
+        "if", "then", "else", "fi", "echo", "return", "include", "define", "struct", "int",
+    };
+    QByteArray out;
+    out.reserve(size + 16);
+    while (out.size() < size) {
+        out.append(words[(*rng)() % (sizeof(words) / sizeof(words[0]))]);
+        out.append((*rng)() % 9 == 0 ? '\n' : ' ');
+    }
+    out.resize(size);
+    return out;
+}
+
+void collectDirs(const QString &path, int depth, int fanout, QStringList *dirs) {
+    dirs->push_back(path);
+    if (depth == 0) {
+        return;
+    }
+    for (int i = 0; i < fanout; ++i) {
+        collectDirs(path + QString("/d%1").arg(i, 2, 10, QChar('0')), depth - 1, fanout, dirs);
+    }
+}
+
+bool fail(QString *error, const QString &message) {
+    if (error) {
+        *error = message;
+    }
+    return false;
+}
+
+bool sameOptions(const SyntheticDistOptions &a, const SyntheticDistOptions &b) {
+    return a.files == b.files && a.minFileBytes == b.minFileBytes && a.maxFileBytes == b.maxFileBytes &&
+           a.depth == b.depth && a.fanout == b.fanout && a.linkEvery == b.linkEvery &&
+           a.driftEvery == b.driftEvery && a.driftBytes == b.driftBytes && a.seed == b.seed;
+}
+
+struct CachedDist {
+    SyntheticDistOptions options;
+    QTemporaryDir tmp;
+    ParsedDist parsed;
+};
+
+} // namespace
+
+bool generateSyntheticDist(const QString &dir,
+                           const SyntheticDistOptions &options,
+                           SyntheticDist *dist,
+                           QString *error) {
+    if (!dist || !QDir().mkpath(dir)) {
+        return fail(error, QString("Cannot create %1").arg(dir));
+    }
+    *dist = SyntheticDist();
+    dist->dir = dir;
+    dist->product = "synth";
+
+    QFile idb(QDir(dir).filePath("synth.idb"));
+    QFile sw(QDir(dir).filePath("synth.sw"));
+    QFile man(QDir(dir).filePath("synth.man"));
+    for (QFile *f : {&idb, &sw, &man}) {
+        if (!f->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return fail(error, QString("Cannot write %1").arg(f->fileName()));
+        }
+    }
+    sw.write(kSubproductHeader, 13);
+    man.write(kSubproductHeader, 13);
+
+    QStringList dirs;
+    collectDirs("usr/share/synth", std::max(0, options.depth), std::max(1, options.fanout), &dirs);
+
+    std::mt19937 rng(options.seed);
+    std::mt19937 driftRng(options.seed ^ 0x9e3779b9u);
+    const int minBytes = std::max(0, options.minFileBytes);
+    const int spread = std::max(0, options.maxFileBytes - minBytes) + 1;
+    QByteArray idbText;
+
+    auto addLine = [&](char ftype, const char *mode, const QByteArray &path, const char *subgroup,
+                       const QByteArray &attrs) {
+        idbText.append(ftype);
+        idbText.append(' ');
+        idbText.append(mode);
+        idbText.append(" root sys ");
+        idbText.append(path);
+        idbText.append(' ');
+        idbText.append(path);
+        idbText.append(' ');
+        idbText.append(subgroup);
+        if (!attrs.isEmpty()) {
+            idbText.append(' ');
+            idbText.append(attrs);
+        }
+        idbText.append('\n');
+        ++dist->entries;
+    };
+
+    // Files are spread evenly over the tree; the idb lists each directory
+    // followed by its contents, in the order the payloads are stored.
+    int nextFile = 0;
+    for (int d = 0; d < dirs.size(); ++d) {
+        const QByteArray dirPath = dirs.at(d).toLatin1();
+        addLine('d', "0755", dirPath, "synth.sw.base", QByteArray());
+
+        const int count = options.files / int(dirs.size()) + (d < options.files % int(dirs.size()) ? 1 : 0);
+        for (int k = 0; k < count; ++k, ++nextFile) {
+            const bool isMan = nextFile % 5 == 0;
+            const QByteArray name = dirPath + (isMan ? QByteArray("/page") : QByteArray("/file")) +
+                                    QByteArray::number(nextFile) + (isMan ? ".1" : ".txt");
+            const QByteArray raw = fileContent(&rng, minBytes + int(rng() % quint32(spread)));
+            const QByteArray packed = lzwCompress(raw);
+
+            QFile *sub = isMan ? &man : &sw;
+            if (options.driftEvery > 0 && nextFile > 0 && nextFile % options.driftEvery == 0) {
+                QByteArray junk(std::max(1, options.driftBytes), Qt::Uninitialized);
+                for (char &c : junk) {
+                    c = char('a' + driftRng() % 26);
+                }
+                sub->write(junk);
+                ++dist->drifts;
+            }
+            const char header[2] = {char((name.size() >> 8) & 0xFF), char(name.size() & 0xFF)};
+            sub->write(header, 2);
+            sub->write(name);
+            sub->write(packed);
+
+            const char *subgroup = isMan ? "synth.man.pages" : (nextFile % 2 ? "synth.sw.lib" : "synth.sw.base");
+            addLine('f', "0644", name, subgroup,
+                    "sum(" + QByteArray::number(quint32(rng() % 65536)) + ") size(" +
+                        QByteArray::number(raw.size()) + ") cmpsize(" + QByteArray::number(packed.size()) +
+                        ") mach(CPUARCH=R4000 CPUARCH=R10000)");
+            ++dist->files;
+            dist->rawBytes += raw.size();
+            dist->packedBytes += packed.size();
+
+            if (options.linkEvery > 0 && nextFile % options.linkEvery == 0) {
+                addLine('l', "0777", name + ".link", "synth.sw.lib",
+                        "symval(" + name.mid(name.lastIndexOf('/') + 1) + ")");
+            }
+        }
+    }
+
+    idb.write(idbText);
+    dist->idbBytes = idbText.size();
+    for (QFile *f : {&idb, &sw, &man}) {
+        f->close();
+        if (f->error() != QFileDevice::NoError) {
+            return fail(error, QString("Cannot write %1").arg(f->fileName()));
+        }
+    }
+    return true;
+}
+
+const ParsedDist &parsedSyntheticDist(const SyntheticDistOptions &options) {
+    static std::vector<std::unique_ptr<CachedDist>> cache;
+    for (const auto &cached : cache) {
+        if (sameOptions(cached->options, options)) {
+            return cached->parsed;
+        }
+    }
+
+    auto cached = std::make_unique<CachedDist>();
+    cached->options = options;
+    ParsedDist &p = cached->parsed;
+    QString error;
+    if (!cached->tmp.isValid() || !generateSyntheticDist(cached->tmp.filePath("dist"), options, &p.dist, &error)) {
+        std::fprintf(stderr, "Cannot generate synthetic dist: %s\n", qPrintable(error));
+        std::abort();
+    }
+    p.workDir = cached->tmp.path();
+    p.distDir = swcore::DistDirectory(p.dist.dir);
+    p.parsed = swcore::IdbParser::parse(p.distDir, p.dist.product, &error);
+    if (!error.isEmpty() || p.parsed.entries.size() != p.dist.entries) {
+        std::fprintf(stderr, "Parse failed: %s\n", qPrintable(error));
+        std::abort();
+    }
+    cache.push_back(std::move(cached));
+    return cache.back()->parsed;
+}
+
+} // namespace swbench
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "swcore/dist_directory.h"
+#include "swcore/types.h"
+
+#include <QString>
+#include <QtGlobal>
+
+namespace swbench {
+
+struct SyntheticDistOptions {
+    int files = 2000;
+    int minFileBytes = 256;
+    int maxFileBytes = 4096;
+    // Directory tree shape below usr/share/synth.
+    int depth = 3;
+    int fanout = 8;
+    // Every Nth file is followed by a symlink to it; 0 disables links.
+    int linkEvery = 16;
+    // Every Nth payload is preceded by driftBytes of junk that the idb
+    // offsets do not account for, so extraction has to resync; 0 disables.
+    int driftEvery = 0;
+    int driftBytes = 4096;
+    quint32 seed = 1;
+};
+
+struct SyntheticDist {
+    QString dir;
+    QString product;
+    qint64 idbBytes = 0;
+    int entries = 0;
+    int files = 0;
+    qint64 rawBytes = 0;
+    qint64 packedBytes = 0;
+    int drifts = 0;
+};
+
+// Writes a deterministic IRIX-style dist (product "synth": one idb plus the
+// synth.sw and synth.man subproduct files with .Z payloads) into dir.
+bool generateSyntheticDist(const QString &dir,
+                           const SyntheticDistOptions &options,
+                           SyntheticDist *dist,
+                           QString *error = nullptr);
+
+struct ParsedDist {
+    SyntheticDist dist;
+    swcore::DistDirectory distDir;
+    swcore::ParseResult parsed;
+    // Temporary directory holding the dist, for a case's own scratch files.
+    QString workDir;
+};
+
+// The dist generated from options and its parse, made on first use and kept
+// for the rest of the run; aborts if either fails.
+const ParsedDist &parsedSyntheticDist(const SyntheticDistOptions &options);
+
+} // namespace swbench
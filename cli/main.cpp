@@ -0,0 +1,404 @@
+#include "swcore/dist_directory.h"
+#include "swcore/entry_store.h"
+#include "swcore/extractor.h"
+#include "swcore/idb_parser.h"
+#include "swcore/path_index.h"
+#include "swcore/wildcard.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTextStream>
+
+#include <algorithm>
+#include <vector>
+
+#ifndef SW_EXPLORER_VERSION
+#define SW_EXPLORER_VERSION "0.1.0"
+#endif
+
+namespace {
+
+enum class OutputFormat {
+    Text,
+    Json,
+    Csv
+};
+
+struct Selection {
+    swcore::WildcardMask mask;
+    std::vector<swcore::PathQuery> globs;
+};
+
+struct ProductReport {
+    QString product;
+    int parsedEntries = 0;
+    int selectedEntries = 0;
+    int warnings = 0;
+    qint64 parseNs = 0;
+    bool extracted = false;
+    QString error;
+    swcore::ExtractResult result;
+};
+
+QTextStream &out() {
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+QTextStream &err() {
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+// Live status of the product being extracted, redrawn in place on stderr at
+// most every kRedrawMs: payload percentage, entries and throughput.
+class ProgressLine {
+public:
+    static constexpr qint64 kRedrawMs = 250;
+
+    explicit ProgressLine(const QString &product) : m_product(product) { m_wall.start(); }
+
+    bool update(const swcore::DistExtractor::ByteProgress &progress) {
+        if (m_redraw.isValid() && m_redraw.elapsed() < kRedrawMs) {
+            return true;
+        }
+        m_redraw.start();
+        double percent = 0;
+        if (progress.bytesTotal > 0) {
+            percent = 100.0 * double(progress.bytesDone) / double(progress.bytesTotal);
+        } else if (progress.entriesTotal > 0) {
+            percent = 100.0 * progress.entriesDone / progress.entriesTotal;
+        }
+        const double wall = m_wall.nsecsElapsed() / 1e9;
+        const double rate = wall > 0 ? progress.bytesDone / wall / (1024.0 * 1024.0) : 0.0;
+        const QString line = QString("%1: %2%, %3/%4 entries, %5 MB/s")
+                                 .arg(m_product)
+                                 .arg(percent, 0, 'f', 1)
+                                 .arg(progress.entriesDone)
+                                 .arg(progress.entriesTotal)
+                                 .arg(rate, 0, 'f', 1);
+        err() << '\r' << line.leftJustified(m_width);
+        err().flush();
+        m_width = std::max(m_width, int(line.size()));
+        return true;
+    }
+
+    void clear() {
+        if (m_width > 0) {
+            err() << '\r' << QString(m_width, ' ') << '\r';
+            err().flush();
+        }
+    }
+
+private:
+    QString m_product;
+    QElapsedTimer m_wall;
+    QElapsedTimer m_redraw;
+    int m_width = 0;
+};
+
+// Same rules as the GUI: the mask matches subgroups, and a glob matches the
+// entry path or its source path, case-insensitively.
+QVector<swcore::FileEntry> selectEntries(const QVector<swcore::FileEntry> &entries, const Selection &selection) {
+    QVector<swcore::FileEntry> selected;
+    selected.reserve(entries.size());
+    for (const swcore::FileEntry &entry : entries) {
+        if (!selection.mask.matchesAll() && !selection.mask.matches(entry.subgroup)) {
+            continue;
+        }
+        if (!selection.globs.empty()) {
+            const QString path = swcore::EntryStore::normalizedPath(entry.fname);
+            bool hit = false;
+            for (const swcore::PathQuery &glob : selection.globs) {
+                if (glob.matches(path, entry.sourcePath)) {
+                    hit = true;
+                    break;
+                }
+            }
+            if (!hit) {
+                continue;
+            }
+        }
+        selected.push_back(entry);
+    }
+    return selected;
+}
+
+QJsonObject reportToJson(const ProductReport &report) {
+    QJsonObject obj;
+    obj["product"] = report.product;
+    obj["parsedEntries"] = report.parsedEntries;
+    obj["selectedEntries"] = report.selectedEntries;
+    obj["warnings"] = report.warnings;
+    obj["parseNs"] = double(report.parseNs);
+    if (!report.error.isEmpty()) {
+        obj["error"] = report.error;
+    }
+    if (!report.extracted) {
+        return obj;
+    }
+
+    const swcore::ExtractResult &r = report.result;
+    obj["total"] = r.total;
+    obj["extracted"] = r.extracted;
+    obj["skipped"] = r.skipped;
+    obj["errors"] = r.errors;
+    obj["canceled"] = r.canceled;
+    obj["bytesRead"] = double(r.bytesRead);
+    obj["bytesWritten"] = double(r.bytesWritten);
+    obj["elapsedNs"] = double(r.elapsedNs);
+
+    QJsonObject timings;
+    timings["locateNs"] = double(r.timings.locateNs);
+    timings["readNs"] = double(r.timings.readNs);
+    timings["decodeNs"] = double(r.timings.decodeNs);
+    timings["writeNs"] = double(r.timings.writeNs);
+    timings["chmodNs"] = double(r.timings.chmodNs);
+    obj["timings"] = timings;
+    obj["errorMessages"] = QJsonArray::fromStringList(r.errorMessages);
+    return obj;
+}
+
+QString csvField(const QString &value) {
+    if (!value.contains(',') && !value.contains('"') && !value.contains('\n')) {
+        return value;
+    }
+    QString quoted = value;
+    quoted.replace('"', "\"\"");
+    return '"' + quoted + '"';
+}
+
+void printCsv(const QVector<ProductReport> &reports) {
+    out() << "product,parsed_entries,selected_entries,warnings,parse_ns,total,extracted,skipped,errors,canceled,"
+             "bytes_read,bytes_written,elapsed_ns,locate_ns,read_ns,decode_ns,write_ns,chmod_ns,error\n";
+    for (const ProductReport &report : reports) {
+        const swcore::ExtractResult &r = report.result;
+        QStringList fields{csvField(report.product),
+                           QString::number(report.parsedEntries),
+                           QString::number(report.selectedEntries),
+                           QString::number(report.warnings),
+                           QString::number(report.parseNs),
+                           QString::number(r.total),
+                           QString::number(r.extracted),
+                           QString::number(r.skipped),
+                           QString::number(r.errors),
+                           r.canceled ? "1" : "0",
+                           QString::number(r.bytesRead),
+                           QString::number(r.bytesWritten),
+                           QString::number(r.elapsedNs),
+                           QString::number(r.timings.locateNs),
+                           QString::number(r.timings.readNs),
+                           QString::number(r.timings.decodeNs),
+                           QString::number(r.timings.writeNs),
+                           QString::number(r.timings.chmodNs)};
+        QString error = report.error;
+        if (error.isEmpty() && !r.errorMessages.isEmpty()) {
+            error = r.errorMessages.first();
+        }
+        fields.push_back(csvField(error));
+        out() << fields.join(',') << '\n';
+    }
+}
+
+QString seconds(qint64 ns) {
+    return QString::number(ns / 1e9, 'f', 3);
+}
+
+void printText(const ProductReport &report) {
+    out() << report.product << ": " << report.parsedEntries << " entries parsed in " << seconds(report.parseNs)
+          << " s";
+    if (report.warnings > 0) {
+        out() << " (" << report.warnings << " warnings)";
+    }
+    out() << ", " << report.selectedEntries << " selected\n";
+    if (!report.error.isEmpty()) {
+        out() << "  error: " << report.error << '\n';
+    }
+    if (!report.extracted) {
+        return;
+    }
+
+    const swcore::ExtractResult &r = report.result;
+    const double wall = r.elapsedNs / 1e9;
+    out() << "  extracted " << r.extracted << ", skipped " << r.skipped << ", errors " << r.errors
+          << (r.canceled ? ", canceled" : "") << '\n';
+    out() << "  read " << QString::number(r.bytesRead / (1024.0 * 1024.0), 'f', 1) << " MB, wrote "
+          << QString::number(r.bytesWritten / (1024.0 * 1024.0), 'f', 1) << " MB in " << seconds(r.elapsedNs)
+          << " s";
+    if (wall > 0) {
+        out() << " (" << QString::number(r.bytesRead / wall / (1024.0 * 1024.0), 'f', 1) << " MB/s)";
+    }
+    out() << '\n';
+    out() << "  locate " << seconds(r.timings.locateNs) << " s, read " << seconds(r.timings.readNs) << " s, decode "
+          << seconds(r.timings.decodeNs) << " s, write " << seconds(r.timings.writeNs) << " s, chmod "
+          << seconds(r.timings.chmodNs) << " s\n";
+    for (const QString &message : r.errorMessages) {
+        out() << "  " << message << '\n';
+    }
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("sw-extract");
+    app.setApplicationVersion(QStringLiteral(SW_EXPLORER_VERSION));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Lists, parses and extracts IRIX dist products without a GUI.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("dist", "Dist directory holding the .idb and subproduct files.");
+    parser.addPositionalArgument("products", "Products to process; all products when omitted.", "[product...]");
+
+    const QCommandLineOption listOption({"l", "list"}, "List the products of the dist and exit.");
+    const QCommandLineOption outputOption({"o", "output"}, "Extract into <dir>. Without it products are only parsed.",
+                                          "dir");
+    const QCommandLineOption maskOption({"m", "mask"},
+                                        "Subgroup mask: wildcards separated by commas or spaces, '!' excludes.",
+                                        "mask",
+                                        "*");
+    const QCommandLineOption globOption({"g", "glob"},
+                                        "Only entries whose path or source path matches <pattern>; repeatable.",
+                                        "pattern");
+    const QCommandLineOption workersOption({"j", "workers"}, "Payload worker threads; 0 uses every core.", "n", "0");
+    const QCommandLineOption noDecompressOption("no-decompress", "Write the .Z payloads instead of decoding them.");
+    const QCommandLineOption keepZOption("keep-z", "Also keep the .Z payload next to each decoded file.");
+    const QCommandLineOption stopOnErrorOption("stop-on-error", "Stop a product at its first failed entry.");
+    const QCommandLineOption noCacheOption("no-cache",
+                                           "Always parse the .idb and walk the subproduct files instead of "
+                                           "using the caches.");
+    const QCommandLineOption formatOption({"f", "format"}, "Report format: text, json or csv.", "format", "text");
+    parser.addOptions({listOption,
+                       outputOption,
+                       maskOption,
+                       globOption,
+                       workersOption,
+                       noDecompressOption,
+                       keepZOption,
+                       stopOnErrorOption,
+                       noCacheOption,
+                       formatOption});
+    parser.process(app);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.isEmpty()) {
+        err() << "sw-extract: missing dist directory\n";
+        parser.showHelp(2);
+    }
+
+    OutputFormat format = OutputFormat::Text;
+    const QString formatName = parser.value(formatOption).toLower();
+    if (formatName == "json") {
+        format = OutputFormat::Json;
+    } else if (formatName == "csv") {
+        format = OutputFormat::Csv;
+    } else if (formatName != "text") {
+        err() << "sw-extract: unknown format " << formatName << '\n';
+        return 2;
+    }
+
+    bool workersOk = false;
+    const int workers = parser.value(workersOption).toInt(&workersOk);
+    if (!workersOk || workers < 0) {
+        err() << "sw-extract: invalid worker count " << parser.value(workersOption) << '\n';
+        return 2;
+    }
+
+    const swcore::DistDirectory dist(positional.first());
+    if (!dist.isValid()) {
+        err() << "sw-extract: cannot read dist directory " << positional.first() << '\n';
+        return 1;
+    }
+
+    if (parser.isSet(listOption)) {
+        const QStringList products = dist.products();
+        if (format == OutputFormat::Json) {
+            out() << QJsonDocument(QJsonArray::fromStringList(products)).toJson(QJsonDocument::Indented);
+        } else {
+            for (const QString &product : products) {
+                out() << product << '\n';
+            }
+        }
+        return 0;
+    }
+
+    QStringList products = positional.mid(1);
+    if (products.isEmpty()) {
+        products = dist.products();
+    }
+
+    Selection selection;
+    selection.mask = swcore::WildcardMask(parser.value(maskOption));
+    for (const QString &pattern : parser.values(globOption)) {
+        selection.globs.emplace_back(pattern);
+    }
+
+    swcore::ExtractOptions options;
+    options.workers = workers;
+    options.noDecompress = parser.isSet(noDecompressOption);
+    options.keepZ = parser.isSet(keepZOption);
+    options.continueOnError = !parser.isSet(stopOnErrorOption);
+    options.cachePayloadMaps = !parser.isSet(noCacheOption);
+    const QString outDir = parser.value(outputOption);
+
+    QVector<ProductReport> reports;
+    bool failed = false;
+    for (const QString &product : products) {
+        ProductReport report;
+        report.product = product;
+
+        QElapsedTimer timer;
+        timer.start();
+        QString error;
+        const swcore::ParseResult parsed = parser.isSet(noCacheOption)
+                                               ? swcore::IdbParser::parse(dist, product, &error)
+                                               : swcore::IdbParser::parseCached(dist, product, QString(), &error);
+        report.parseNs = timer.nsecsElapsed();
+        report.parsedEntries = parsed.entries.size();
+        report.warnings = parsed.warnings.size();
+
+        if (!error.isEmpty()) {
+            report.error = error;
+            failed = true;
+        } else {
+            const QVector<swcore::FileEntry> selected = selectEntries(parsed.entries, selection);
+            report.selectedEntries = selected.size();
+            if (!outDir.isEmpty() && !selected.isEmpty()) {
+                // Machine-readable reports keep stderr free of status lines.
+                ProgressLine line(product);
+                swcore::DistExtractor::ByteProgressCallback progress;
+                if (format == OutputFormat::Text) {
+                    progress = [&line](const swcore::DistExtractor::ByteProgress &p) { return line.update(p); };
+                }
+                report.result = swcore::DistExtractor::extract(dist, selected, outDir, options, progress);
+                line.clear();
+                report.extracted = true;
+                failed = failed || report.result.errors > 0;
+            }
+        }
+
+        if (format == OutputFormat::Text) {
+            printText(report);
+            out().flush();
+        }
+        reports.push_back(report);
+    }
+
+    if (format == OutputFormat::Json) {
+        QJsonArray array;
+        for (const ProductReport &report : reports) {
+            array.append(reportToJson(report));
+        }
+        out() << QJsonDocument(array).toJson(QJsonDocument::Indented);
+    } else if (format == OutputFormat::Csv) {
+        printCsv(reports);
+    }
+    return failed ? 1 : 0;
+}
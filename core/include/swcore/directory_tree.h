@@ -0,0 +1,58 @@
+#pragma once
+
+#include "swcore/entry_store.h"
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include <vector>
+
+namespace swcore {
+
+// Directory hierarchy over a subset of an EntryStore. Directories come from
+// 'd' entries and from the ancestors of every path, so listing a folder is a
+// walk over its children instead of a scan of all entries. Built once per
+// entry set / subgroup selection.
+class DirectoryTree {
+public:
+    struct Node {
+        QString name;
+        QString path;
+        int parent = -1;
+        // Child directories sorted by name, and the non-directory entries
+        // directly inside, sorted case-insensitively by base name.
+        std::vector<int> dirs;
+        std::vector<int> files;
+        // Entries whose path is this directory itself ('d' entries).
+        std::vector<int> selfEntries;
+        // Aggregates over the whole subtree.
+        int entryCount = 0;
+        qint64 totalSize = 0;
+    };
+
+    DirectoryTree() = default;
+    DirectoryTree(const EntryStore &store, const QVector<int> &indexes);
+
+    bool isEmpty() const { return m_nodes.empty(); }
+    int root() const { return m_nodes.empty() ? -1 : 0; }
+    int nodeCount() const { return int(m_nodes.size()); }
+    const Node &node(int id) const { return m_nodes[size_t(id)]; }
+
+    // Node for a normalized directory path ("" is the root), or -1.
+    int findDir(const QString &path) const;
+    // Directory holding the entry (its parent), or -1 if it is not in the tree.
+    int parentOf(int entryIndex) const;
+
+    // Appends every entry at or below the directory.
+    void collectEntries(int id, std::vector<int> *out) const;
+
+private:
+    int ensureDir(QStringView path);
+
+    std::vector<Node> m_nodes;
+    QHash<QString, int> m_byPath;
+    std::vector<int> m_entryParent;
+};
+
+} // namespace swcore
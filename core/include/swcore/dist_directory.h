@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QByteArray>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+namespace swcore {
+
+// Snapshot of the entries in a dist directory, listed once. Membership checks
+// are hash lookups instead of a stat() per query, which matters on NFS
+// mounted dist trees. Copies are cheap and share the listing.
+class DistDirectory {
+public:
+    DistDirectory() = default;
+    explicit DistDirectory(const QString &path);
+
+    // Lists the directory again; returns false if it cannot be read.
+    bool refresh();
+
+    bool isValid() const;
+    const QString &path() const;
+    QString filePath(const QString &name) const;
+
+    bool contains(const QString &name) const;
+    bool contains(const char *latin1, int size) const;
+
+    // Base names of the *.idb files, sorted by name.
+    const QStringList &products() const;
+
+    // MD5 over the listed names that could be subproduct files ("a.b"), as
+    // contains() sees them; changes when one appears or disappears.
+    QByteArray subproductFingerprint() const;
+
+private:
+    QString m_path;
+    QSet<QByteArray> m_names;
+    // Lower-cased names, on platforms with case-insensitive file systems.
+    QSet<QByteArray> m_foldedNames;
+    QStringList m_products;
+    bool m_valid = false;
+};
+
+} // namespace swcore
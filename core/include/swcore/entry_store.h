@@ -0,0 +1,72 @@
+#pragma once
+
+#include "swcore/types.h"
+
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+#include <vector>
+
+namespace swcore {
+
+// Columnar copy of a parse result for browsing and filtering. Scalar fields
+// live in contiguous arrays, normalized paths and lower-cased base names in
+// one string arena each (addressed by offset/length), and subgroups as ids
+// into a table of distinct values. The source entries are kept for callers
+// that need a full FileEntry (extraction).
+class EntryStore {
+public:
+    EntryStore() = default;
+    explicit EntryStore(QVector<FileEntry> entries);
+
+    int count() const { return m_entries.size(); }
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    const QVector<FileEntry> &entries() const { return m_entries; }
+    const FileEntry &entry(int i) const { return m_entries.at(i); }
+
+    char ftype(int i) const { return m_ftype[size_t(i)]; }
+    int mode(int i) const { return m_mode[size_t(i)]; }
+    qint64 fileSize(int i) const { return m_size[size_t(i)]; }
+    qint64 packedSize(int i) const { return m_cmpsize[size_t(i)]; }
+    qint64 payloadSize(int i) const { return m_payloadSize[size_t(i)]; }
+    qint64 offset(int i) const { return m_offset[size_t(i)]; }
+
+    // Entry path as shown in the browser (see normalizedPath()).
+    QStringView path(int i) const;
+    QStringView parentPath(int i) const;
+    QStringView baseName(int i) const;
+    QStringView baseNameLower(int i) const;
+
+    int subgroupId(int i) const { return int(m_subgroup[size_t(i)]); }
+    const QStringList &subgroups() const { return m_subgroups; }
+
+    // Unifies separators, drops leading '/' and resolves '.' and '..'.
+    static QString normalizedPath(const QString &path);
+
+private:
+    QVector<FileEntry> m_entries;
+
+    std::vector<char> m_ftype;
+    std::vector<int> m_mode;
+    std::vector<qint64> m_size;
+    std::vector<qint64> m_cmpsize;
+    std::vector<qint64> m_payloadSize;
+    std::vector<qint64> m_offset;
+
+    QString m_paths;
+    std::vector<quint32> m_pathOffset;
+    std::vector<quint32> m_pathLength;
+    // Length of the parent prefix; the base name starts one past it (or at 0
+    // for top-level paths).
+    std::vector<quint32> m_parentLength;
+
+    QString m_lowerNames;
+    std::vector<quint32> m_lowerOffset;
+    std::vector<quint32> m_lowerLength;
+
+    QStringList m_subgroups;
+    std::vector<quint32> m_subgroup;
+};
+
+} // namespace swcore
@@ -2,20 +2,87 @@
 
 #include "swcore/types.h"
 
+#include <QMutex>
+#include <QString>
+
+#include <atomic>
 #include <functional>
 
 namespace swcore {
 
+class DistDirectory;
+
+// Progress of a running extraction, shared between the extracting thread(s)
+// and observers that poll it from elsewhere. Byte counts are payload bytes
+// read from the subproduct files. cancel() is honoured at the next buffer,
+// so a large payload does not delay it; interrupted outputs are discarded.
+class ExtractProgress {
+public:
+    void cancel() { m_canceled.store(true); }
+    bool isCanceled() const { return m_canceled.load(std::memory_order_relaxed); }
+
+    int entriesDone() const { return m_entriesDone.load(std::memory_order_relaxed); }
+    int entriesTotal() const { return m_entriesTotal.load(std::memory_order_relaxed); }
+    qint64 bytesDone() const { return m_bytesDone.load(std::memory_order_relaxed); }
+    qint64 bytesTotal() const { return m_bytesTotal.load(std::memory_order_relaxed); }
+    QString currentFile() const;
+
+    // Called by the extractor.
+    void begin(int entriesTotal, qint64 bytesTotal);
+    void setCurrentFile(const QString &name);
+    void addBytes(qint64 bytes) { m_bytesDone.fetch_add(bytes, std::memory_order_relaxed); }
+    void finishEntry() { m_entriesDone.fetch_add(1, std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> m_canceled{false};
+    std::atomic<int> m_entriesDone{0};
+    std::atomic<int> m_entriesTotal{0};
+    std::atomic<qint64> m_bytesDone{0};
+    std::atomic<qint64> m_bytesTotal{0};
+    mutable QMutex m_fileMutex;
+    QString m_currentFile;
+};
+
 class DistExtractor {
 public:
+    // Called on the calling thread as entries finish, in input order even
+    // when payloads run in another order: current counts the finished
+    // entries and name is the last of them. Returning false cancels the run.
     using ProgressCallback = std::function<bool(int current, int total, const QString &name)>;
 
+    // Byte-weighted progress: payload bytes read out of the payload bytes of
+    // all selected files, so one large file among many small ones moves the
+    // total in proportion to its size.
+    struct ByteProgress {
+        qint64 bytesDone = 0;
+        qint64 bytesTotal = 0;
+        int entriesDone = 0;
+        int entriesTotal = 0;
+        QString currentFile;
+    };
+    // Called on the calling thread, at most every 50 ms: between entries,
+    // between payload buffers when extracting sequentially, and while
+    // waiting for workers. Returning false cancels the run.
+    using ByteProgressCallback = std::function<bool(const ByteProgress &progress)>;
+
     static ExtractResult extract(const QString &distDirPath,
                                  const QVector<FileEntry> &entries,
                                  const QString &outDirPath,
                                  const ExtractOptions &options,
-                                 const ProgressCallback &progress = {});
+                                 const ProgressCallback &progress = {},
+                                 ExtractProgress *state = nullptr);
+    static ExtractResult extract(const DistDirectory &dist,
+                                 const QVector<FileEntry> &entries,
+                                 const QString &outDirPath,
+                                 const ExtractOptions &options,
+                                 const ProgressCallback &progress = {},
+                                 ExtractProgress *state = nullptr);
+    static ExtractResult extract(const DistDirectory &dist,
+                                 const QVector<FileEntry> &entries,
+                                 const QString &outDirPath,
+                                 const ExtractOptions &options,
+                                 const ByteProgressCallback &progress,
+                                 ExtractProgress *state = nullptr);
 };
 
 } // namespace swcore
-
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "swcore/types.h"
+
+#include <QByteArray>
+
+namespace swcore {
+
+class DistDirectory;
+
+// Identity of an idb file as seen by the index cache. A cached index is only
+// used when path, size, mtime and content hash all match, and the dist still
+// lists the same subproduct names (the parse depends on which exist).
+struct IdbCacheKey {
+    QString idbPath;
+    qint64 size = -1;
+    qint64 mtimeMs = 0;
+    QByteArray hash;
+    QByteArray distHash;
+
+    bool isValid() const { return size >= 0 && !hash.isEmpty() && !distHash.isEmpty(); }
+};
+
+// Persistent binary index of parsed idb files. Each index stores the
+// ParseResult with every distinct string written once; it is memory mapped
+// on load and entries share one QString per distinct value. A cache
+// directory keeps the most recently stored indexes only.
+class IdbCache {
+public:
+    static QString defaultDirectory();
+    static IdbCacheKey keyFor(const DistDirectory &dist, const QString &product);
+
+    static bool load(const QString &cacheDir, const IdbCacheKey &key, ParseResult *result);
+    static bool store(const QString &cacheDir, const IdbCacheKey &key, const ParseResult &result);
+};
+
+} // namespace swcore
@@ -4,10 +4,26 @@
 
 namespace swcore {
 
+class DistDirectory;
+
 class IdbParser {
 public:
     static QStringList findProducts(const QString &distDirPath);
+    static QStringList findProducts(const DistDirectory &dist);
     static ParseResult parse(const QString &distDirPath, const QString &product, QString *errorMessage = nullptr);
+    // Resolves subproduct references against the dist snapshot instead of
+    // stat()ing each candidate.
+    static ParseResult parse(const DistDirectory &dist, const QString &product, QString *errorMessage = nullptr);
+    // parse() backed by the IdbCache index in cacheDir (the default cache
+    // location when empty); the index is refreshed after every real parse.
+    static ParseResult parseCached(const QString &distDirPath,
+                                   const QString &product,
+                                   const QString &cacheDir = QString(),
+                                   QString *errorMessage = nullptr);
+    static ParseResult parseCached(const DistDirectory &dist,
+                                   const QString &product,
+                                   const QString &cacheDir = QString(),
+                                   QString *errorMessage = nullptr);
 };
 
 } // namespace swcore
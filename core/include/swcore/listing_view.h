@@ -0,0 +1,64 @@
+#pragma once
+
+#include "swcore/directory_tree.h"
+#include "swcore/entry_store.h"
+#include "swcore/path_index.h"
+
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace swcore {
+
+// The levels a directory listing of an EntryStore is filtered through.
+// Views are built on a worker and never modified afterwards, so one can be
+// displayed while the next is computed; each level is reused by later
+// rebuilds as long as its inputs are unchanged.
+
+// Entries selected by a subgroup mask, and their directory tree.
+struct SubgroupView {
+    std::shared_ptr<const EntryStore> store;
+    QString mask;
+    QVector<int> indexes;
+    DirectoryTree tree;
+
+    static std::shared_ptr<const SubgroupView> build(const std::shared_ptr<const EntryStore> &store,
+                                                     const QString &mask);
+};
+
+// A name or path filter over a SubgroupView.
+struct NameView {
+    std::shared_ptr<const SubgroupView> subgroups;
+    QString filter;
+    QString filterLower;
+    PathQuery pathQuery;
+    // Entries matching the filter; entryMatches flags them by entry index
+    // and matchDirs flags tree nodes with a match below them.
+    QVector<int> matches;
+    std::vector<char> entryMatches;
+    std::vector<char> matchDirs;
+
+    // Filters containing '/' or glob characters search full and source
+    // paths instead of base names.
+    static bool isPathQuery(const QString &filter);
+
+    // index may be null; base is the previous view, narrowed instead of
+    // rescanned when the filter allows it. Returns null once latest no
+    // longer holds generation.
+    static std::shared_ptr<const NameView> build(const std::shared_ptr<const SubgroupView> &subgroups,
+                                                 const QString &filter,
+                                                 const PathIndex *index,
+                                                 const NameView *base,
+                                                 const std::atomic<quint64> *latest,
+                                                 quint64 generation);
+
+    // Rows listing directory dirId (currentDir's node) as slots among its
+    // children: -1 is the parent row, then come the child directories and
+    // the files in tree order, skipping those the filter hides.
+    QVector<int> rows(const QString &currentDir, int dirId) const;
+};
+
+} // namespace swcore
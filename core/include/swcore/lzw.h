@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QByteArray>
+
+#include <vector>
+
+namespace swcore {
+
+bool isCompressStream(const char *data, qint64 size);
+bool isCompressStream(const QByteArray &data);
+
+// Decodes a complete Unix compress (.Z) stream. sizeHint is the expected
+// decoded size, if known; only up to 16 times the input is reserved from it.
+// Throws std::runtime_error on corrupt input.
+QByteArray unlzw(const QByteArray &input, qint64 sizeHint = -1);
+
+// Incremental .Z decoder with bounded memory: push compressed bytes with
+// feed(), pull decoded bytes with drain(). Memory use is independent of the
+// stream length (dictionary plus at most one pending dictionary string).
+// drain() throws std::runtime_error on corrupt input.
+class LzwDecoder {
+public:
+    void reset();
+
+    void feed(const char *data, qint64 size);
+    // Like feed(), but borrows the bytes instead of copying them when the
+    // decoder holds no buffered input (e.g. a whole mapped payload fed at
+    // once). The data must stay valid until the stream has been drained.
+    void feedView(const char *data, qint64 size);
+    // Marks the end of input so the final partial code group can be decoded.
+    void finish();
+
+    // Writes up to capacity decoded bytes to out. Returns 0 when more input
+    // is needed or the stream has ended.
+    qint64 drain(char *out, qint64 capacity);
+    bool atEnd() const;
+
+private:
+    struct Code {
+        quint16 prefix = 0;
+        quint8 suffix = 0;
+        quint8 first = 0;
+        quint32 length = 0;
+    };
+
+    bool readHeader();
+    bool beginGroup();
+    void writeString(int code, char *dst) const;
+    void compactInput();
+    const uchar *inputData() const;
+    qint64 inputSize() const;
+
+    std::vector<uchar> m_in;
+    const uchar *m_view = nullptr;
+    qint64 m_viewSize = 0;
+    std::vector<Code> m_table;
+    std::vector<char> m_pending;
+    qint64 m_pendingPos = 0;
+    qint64 m_pendingLen = 0;
+
+    bool m_headerDone = false;
+    bool m_finished = false;
+    bool m_ended = false;
+    bool m_blockMode = false;
+    int m_maxBits = 0;
+    int m_maxMaxCode = 0;
+    int m_nBits = 0;
+    int m_maxCode = 0;
+    int m_freeEnt = 0;
+    bool m_clearFlag = false;
+    int m_oldCode = -1;
+
+    qint64 m_groupStart = 0;
+    qint64 m_groupBytes = 0;
+    qint64 m_bitPos = 0;
+    int m_codesLeft = 0;
+};
+
+} // namespace swcore
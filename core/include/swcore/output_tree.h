@@ -0,0 +1,107 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+#include <deque>
+#include <memory>
+
+class QSaveFile;
+
+namespace swcore {
+
+// The extraction output below one root directory. Directories created or
+// opened once are remembered with an open descriptor, so new entries are made
+// relative to their parent (mkdirat, openat, symlinkat) instead of resolving
+// the whole path again for every file. Paths are relative to the root and
+// already sanitized. Thread-safe; on systems without the *at() calls it falls
+// back to QDir/QFile with a cache of created directories.
+class OutputTree {
+public:
+    explicit OutputTree(const QString &root);
+    ~OutputTree();
+
+    OutputTree(const OutputTree &) = delete;
+    OutputTree &operator=(const OutputTree &) = delete;
+
+    // False when the root cannot be created or opened.
+    bool isValid() const;
+    const QString &root() const { return m_root; }
+    QString absolutePath(const QString &relPath) const;
+
+    // Creates relDir and any missing parents; "" is the root.
+    bool ensureDir(const QString &relDir);
+    // Replaces whatever is at relPath (except a directory) with a symlink.
+    bool createSymlink(const QString &relPath, const QString &target);
+
+    // Directory modes are only recorded here, so a read-only mode does not
+    // get in the way of writes below it, and applied by applyMetadata().
+    void setDirMode(const QString &relDir, int mode);
+    // Applies the recorded metadata deepest directory first, through
+    // directory descriptors. Call once, after the last write.
+    void applyMetadata();
+
+private:
+    friend class OutputFile;
+
+    struct DirHandle;
+    // Open handle of relDir, creating it when missing; null on failure.
+    std::shared_ptr<DirHandle> dirHandle(const QString &relDir);
+    std::shared_ptr<DirHandle> openDir(const QString &relDir);
+    // Gives an existing directory owner write access until applyMetadata().
+    void makeWritable(const QString &relDir, const DirHandle &handle);
+    // Removes abandoned temporaries (an hour untouched, writer not running
+    // here) from an existing directory, the first time this tree opens it.
+    void sweepOnce(const QString &relDir, const DirHandle &handle);
+
+    QString m_root;
+    std::shared_ptr<DirHandle> m_rootHandle;
+    QMutex m_mutex;
+    QHash<QString, std::shared_ptr<DirHandle>> m_dirs;
+    // Insertion order, for closing the oldest handles past kMaxOpenDirs.
+    std::deque<QString> m_order;
+    // Directory modes waiting for applyMetadata().
+    QHash<QString, int> m_pendingModes;
+    QSet<QString> m_swept;
+};
+
+// A file written below an OutputTree through a temporary next to it, renamed
+// over the target on commit() and removed if never committed (like
+// QSaveFile). A killed run leaves its temporaries (.sw-<pid>-<n>.tmp) behind;
+// the next OutputTree over the same directories removes those not modified
+// for an hour whose process is not running on this host. The QSaveFile
+// fallback leaves cleanup to QSaveFile.
+class OutputFile {
+public:
+    OutputFile(OutputTree *tree, const QString &relPath);
+    ~OutputFile();
+
+    OutputFile(const OutputFile &) = delete;
+    OutputFile &operator=(const OutputFile &) = delete;
+
+    // Absolute target path, for messages.
+    QString fileName() const;
+
+    bool open(QString *error);
+    bool write(const char *data, qint64 size);
+    // Applied to the open file, before it replaces the target.
+    bool setMode(int mode);
+    bool commit();
+
+private:
+    void discard();
+
+    OutputTree *m_tree = nullptr;
+    QString m_relPath;
+    std::shared_ptr<OutputTree::DirHandle> m_parent;
+    QByteArray m_name;
+    QByteArray m_tempName;
+    int m_fd = -1;
+    std::unique_ptr<QSaveFile> m_fallback;
+    int m_mode = -1;
+};
+
+} // namespace swcore
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "swcore/entry_store.h"
+#include "swcore/wildcard.h"
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+#include <vector>
+
+namespace swcore {
+
+// A search over entry paths and source paths, case-insensitive. Text with
+// '*', '?' or '[' is a glob matched against the whole path ('*' crosses
+// '/'); anything else is a substring.
+class PathQuery {
+public:
+    PathQuery() = default;
+    explicit PathQuery(const QString &text);
+
+    bool isEmpty() const { return m_folded.isEmpty(); }
+    bool isGlob() const { return m_glob; }
+    const QString &text() const { return m_text; }
+
+    bool matches(QStringView path, QStringView sourcePath) const;
+
+    // Case-folded literal runs every match must contain.
+    const QStringList &literals() const { return m_literals; }
+
+private:
+    QString m_text;
+    QString m_folded;
+    bool m_glob = false;
+    QStringList m_literals;
+    Wildcard m_wildcard;
+};
+
+// Trigram index over EntryStore::path() and FileEntry::sourcePath. Queries
+// intersect the posting lists of the query's literal trigrams and verify the
+// remaining candidates, so searching does not scan every entry. Building is
+// meant to run off the GUI thread; the index is immutable afterwards.
+class PathIndex {
+public:
+    PathIndex() = default;
+    explicit PathIndex(const EntryStore &store);
+
+    bool isEmpty() const { return m_entryCount == 0; }
+    int entryCount() const { return m_entryCount; }
+
+    // Ascending indexes of the entries of store (the one the index was built
+    // from) that match query.
+    std::vector<int> search(const EntryStore &store, const PathQuery &query) const;
+
+private:
+    bool candidates(const QString &literal, std::vector<quint32> *out) const;
+
+    int m_entryCount = 0;
+    QHash<quint64, std::vector<quint32>> m_postings;
+};
+
+} // namespace swcore
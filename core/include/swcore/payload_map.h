@@ -0,0 +1,62 @@
+#pragma once
+
+#include "swcore/types.h"
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace swcore {
+
+class SubproductFile;
+
+// Verified payload positions in one subproduct file. The idb only gives the
+// arithmetic offset of each payload; walkChain() follows the file's
+// [u16 length][name][payload] record chain from the first record instead,
+// checking every header against the name of the idb entry expected there and
+// stepping over the payload by that entry's size. Lookups are then
+// independent of the order entries are extracted in.
+class PayloadMap {
+public:
+    struct Location {
+        qint64 header = -1;
+        qint64 data = -1;
+    };
+
+    static QString defaultDirectory();
+    // The map cached for the file in cacheDir, or an empty map when there is
+    // none or the file changed since it was stored.
+    static PayloadMap load(const QString &cacheDir, const SubproductFile &file);
+    bool store(const QString &cacheDir, const SubproductFile &file) const;
+
+    bool isEmpty() const { return m_locations.isEmpty(); }
+    int count() const { return m_locations.size(); }
+
+    // Location of the entry's payload, or nullptr when it is not mapped.
+    const Location *find(const FileEntry &entry) const;
+
+    // True when every entry is mapped and its header is still where the map
+    // says, so the file needs no new walk for them.
+    bool covers(SubproductFile &file, const QVector<const FileEntry *> &entries) const;
+
+    // Replaces the map with one forward walk over the records of chain, the
+    // 'f' entries stored in file as listed by the idb. A header that is not
+    // where the previous record ends is searched for with the resync window
+    // of options, then at its idb offset. errors receives a message per idb
+    // offset that could not be located.
+    void walkChain(SubproductFile &file,
+                   const QVector<const FileEntry *> &chain,
+                   const ExtractOptions &options,
+                   QHash<qint64, QString> *errors);
+
+private:
+    // Keyed by idb offset; the payload size guards against a changed idb.
+    struct Record {
+        qint64 payloadSize = -1;
+        Location location;
+    };
+
+    QHash<qint64, Record> m_locations;
+};
+
+} // namespace swcore
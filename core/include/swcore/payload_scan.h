@@ -0,0 +1,34 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+#include <optional>
+
+namespace swcore {
+
+class SubproductFile;
+
+// True when hdr holds a payload header for nameBytes: the big-endian u16
+// name length followed by the name itself.
+bool headerMatches(const char *hdr, const QByteArray &nameBytes);
+
+// Spellings a payload header may use for an idb file name: as is, with "./"
+// and with "/" in front, in that order of preference.
+QList<QByteArray> nameVariants(const QString &name);
+
+bool checkHeaderAt(SubproductFile &file, qint64 offset, const QByteArray &nameBytes);
+
+// Searches [baseOffset - back, baseOffset + forward) for the first payload
+// header naming one of variants. Returns the header offset and the matched
+// variant. Unmapped files are read chunkSize bytes at a time.
+std::optional<QPair<qint64, QByteArray>> resyncOffset(SubproductFile &file,
+                                                       const QList<QByteArray> &variants,
+                                                       qint64 baseOffset,
+                                                       qint64 back,
+                                                       qint64 forward,
+                                                       qint64 chunkSize);
+
+} // namespace swcore
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+
+namespace swcore {
+
+// Interning table for the idb fields that repeat across entries (user,
+// group, subgroup, machine expression...). Every distinct value is stored
+// once and handed out as an implicitly shared QString, so entries holding
+// the same value share a single buffer. Copies share the table.
+class StringPool {
+public:
+    QString intern(const char *latin1, int size);
+    QString intern(const QString &s);
+
+    int size() const { return m_strings.size(); }
+    void clear() { m_strings.clear(); }
+
+private:
+    QHash<QByteArray, QString> m_strings;
+};
+
+} // namespace swcore
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+namespace swcore {
+
+// Read-only access to a subproduct payload file. The whole file is memory
+// mapped when possible so header checks, resync scans and payload reads are
+// pointer views; files that cannot be mapped fall back to seek + read.
+class SubproductFile {
+public:
+    explicit SubproductFile(const QString &path);
+    ~SubproductFile();
+
+    SubproductFile(const SubproductFile &) = delete;
+    SubproductFile &operator=(const SubproductFile &) = delete;
+
+    bool open();
+    bool isOpen() const;
+    bool isMapped() const;
+    const QString &path() const;
+    qint64 size() const;
+
+    // Pointer to [offset, offset + length), or nullptr when the file is not
+    // mapped or the range is out of bounds. Safe to call from any thread.
+    const char *view(qint64 offset, qint64 length) const;
+
+    // Copies up to length bytes into dst and returns the count copied.
+    // Unmapped files share one QFile, so this is not thread-safe for them.
+    qint64 read(qint64 offset, char *dst, qint64 length);
+
+    // The bytes in [offset, offset + length) clipped to the file size; a raw
+    // view without copying when mapped. Must not outlive this object.
+    QByteArray bytes(qint64 offset, qint64 length);
+
+    // Page cache hints: the file is read front to back, and [offset, offset +
+    // length) will be read soon. No-ops where the OS has no such advice.
+    void adviseSequential();
+    void willNeed(qint64 offset, qint64 length);
+
+private:
+    QString m_path;
+    QFile m_file;
+    const char *m_map = nullptr;
+    qint64 m_size = 0;
+};
+
+} // namespace swcore
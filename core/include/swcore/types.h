@@ -1,5 +1,7 @@
 #pragma once
 
+#include "swcore/string_pool.h"
+
 #include <QString>
 #include <QStringList>
 #include <QVector>
@@ -28,24 +30,53 @@ struct ParseResult {
     QString product;
     QVector<FileEntry> entries;
     QStringList warnings;
+    // Backs the repeated FileEntry fields (user, group, subgroup,
+    // subproductBase, machExpr); entries share its strings.
+    StringPool strings;
 };
 
 struct ExtractOptions {
     bool noDecompress = false;
     bool keepZ = false;
     bool continueOnError = true;
+    // Threads used to decode and write file payloads; 1 extracts sequentially,
+    // 0 or less uses QThread::idealThreadCount().
+    int workers = 1;
     qint64 resyncBack = 1024 * 1024;
     qint64 resyncForward = 16 * 1024 * 1024;
     qint64 resyncChunk = 1024 * 1024;
+    // Keep the verified payload offsets of each subproduct file for later
+    // runs, in payloadMapDir or PayloadMap::defaultDirectory() when empty.
+    // Off by default so library callers leave nothing behind.
+    bool cachePayloadMaps = false;
+    QString payloadMapDir;
+};
+
+// Time spent per extraction phase in nanoseconds, summed over all threads:
+// locating payloads (including resync scans), reading payload bytes, LZW
+// decoding, creating and writing outputs, and applying modes.
+struct ExtractTimings {
+    qint64 locateNs = 0;
+    qint64 readNs = 0;
+    qint64 decodeNs = 0;
+    qint64 writeNs = 0;
+    qint64 chmodNs = 0;
 };
 
 struct ExtractResult {
     int total = 0;
     int extracted = 0;
+    // Entries of unsupported types, and payloads that a later entry writing
+    // the same path replaces.
     int skipped = 0;
     int errors = 0;
     bool canceled = false;
     QStringList errorMessages;
+    // Compressed payload bytes read and bytes written to output files.
+    qint64 bytesRead = 0;
+    qint64 bytesWritten = 0;
+    qint64 elapsedNs = 0;
+    ExtractTimings timings;
 };
 
 } // namespace swcore
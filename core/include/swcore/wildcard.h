@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QChar>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+
+#include <utility>
+#include <vector>
+
+namespace swcore {
+
+// Compiled shell-style wildcard matched against a whole string: '*' matches
+// any run of characters, '?' one character, and "[a-z]" a set ('!' or '^'
+// after '[' negates it). Matching is case-sensitive; callers fold case on
+// both sides when they need otherwise.
+class Wildcard {
+public:
+    Wildcard() = default;
+    explicit Wildcard(const QString &pattern);
+
+    static bool hasWildcards(const QString &text);
+
+    bool matches(QStringView text) const;
+    // Literal runs between wildcards; every match contains all of them.
+    const QStringList &literals() const { return m_literals; }
+
+private:
+    struct Token {
+        enum Kind { Char, Any, Star, Set } kind = Char;
+        QChar ch;
+        int set = -1;
+    };
+    struct CharSet {
+        bool negated = false;
+        std::vector<std::pair<QChar, QChar>> ranges;
+    };
+
+    bool setContains(int set, QChar c) const;
+
+    std::vector<Token> m_tokens;
+    std::vector<CharSet> m_sets;
+    QStringList m_literals;
+};
+
+// Subgroup mask: wildcards separated by commas or whitespace. A subgroup is
+// selected when it matches any plain pattern (or there are none) and none of
+// the '!'-prefixed ones, e.g. "eoe.*, !*.man.*".
+class WildcardMask {
+public:
+    WildcardMask() = default;
+    explicit WildcardMask(const QString &mask);
+
+    bool matchesAll() const { return m_include.empty() && m_exclude.empty(); }
+    bool matches(QStringView subgroup) const;
+
+private:
+    std::vector<Wildcard> m_include;
+    std::vector<Wildcard> m_exclude;
+};
+
+} // namespace swcore
@@ -0,0 +1,99 @@
+#include "swcore/directory_tree.h"
+
+#include <algorithm>
+
+namespace swcore {
+
+DirectoryTree::DirectoryTree(const EntryStore &store, const QVector<int> &indexes) {
+    m_nodes.emplace_back();
+    m_byPath.insert(QString(), 0);
+    m_entryParent.assign(size_t(store.count()), -1);
+
+    // idb entries are grouped by directory, so the previous parent usually
+    // matches and the path hash is skipped.
+    int lastParent = -1;
+    QStringView lastParentPath;
+    for (int idx : indexes) {
+        if (store.path(idx).isEmpty()) {
+            continue;
+        }
+        const QStringView parentPath = store.parentPath(idx);
+        if (lastParent < 0 || parentPath != lastParentPath) {
+            lastParent = ensureDir(parentPath);
+            lastParentPath = parentPath;
+        }
+        m_entryParent[size_t(idx)] = lastParent;
+
+        if (store.ftype(idx) == 'd') {
+            m_nodes[size_t(ensureDir(store.path(idx)))].selfEntries.push_back(idx);
+        } else {
+            m_nodes[size_t(lastParent)].files.push_back(idx);
+            m_nodes[size_t(lastParent)].totalSize += store.fileSize(idx);
+        }
+    }
+
+    for (Node &node : m_nodes) {
+        std::sort(node.dirs.begin(), node.dirs.end(), [this](int a, int b) {
+            return m_nodes[size_t(a)].name < m_nodes[size_t(b)].name;
+        });
+        std::stable_sort(node.files.begin(), node.files.end(), [&store](int a, int b) {
+            return store.baseName(a).compare(store.baseName(b), Qt::CaseInsensitive) < 0;
+        });
+        node.entryCount = int(node.files.size() + node.selfEntries.size());
+    }
+
+    // Children are always created after their parent.
+    for (int id = int(m_nodes.size()) - 1; id > 0; --id) {
+        Node &parent = m_nodes[size_t(m_nodes[size_t(id)].parent)];
+        parent.entryCount += m_nodes[size_t(id)].entryCount;
+        parent.totalSize += m_nodes[size_t(id)].totalSize;
+    }
+}
+
+int DirectoryTree::findDir(const QString &path) const {
+    return m_byPath.value(path, -1);
+}
+
+int DirectoryTree::parentOf(int entryIndex) const {
+    if (entryIndex < 0 || size_t(entryIndex) >= m_entryParent.size()) {
+        return -1;
+    }
+    return m_entryParent[size_t(entryIndex)];
+}
+
+void DirectoryTree::collectEntries(int id, std::vector<int> *out) const {
+    if (id < 0 || size_t(id) >= m_nodes.size()) {
+        return;
+    }
+    std::vector<int> pending{id};
+    while (!pending.empty()) {
+        const Node &node = m_nodes[size_t(pending.back())];
+        pending.pop_back();
+        out->insert(out->end(), node.selfEntries.begin(), node.selfEntries.end());
+        out->insert(out->end(), node.files.begin(), node.files.end());
+        pending.insert(pending.end(), node.dirs.begin(), node.dirs.end());
+    }
+}
+
+int DirectoryTree::ensureDir(QStringView path) {
+    const QString key = path.toString();
+    const auto it = m_byPath.constFind(key);
+    if (it != m_byPath.constEnd()) {
+        return it.value();
+    }
+
+    const int slash = int(path.lastIndexOf('/'));
+    const int parent = ensureDir(slash < 0 ? QStringView() : path.left(slash));
+
+    Node node;
+    node.name = path.mid(slash + 1).toString();
+    node.path = key;
+    node.parent = parent;
+    const int id = int(m_nodes.size());
+    m_nodes.push_back(std::move(node));
+    m_nodes[size_t(parent)].dirs.push_back(id);
+    m_byPath.insert(key, id);
+    return id;
+}
+
+} // namespace swcore
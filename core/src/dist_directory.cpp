@@ -0,0 +1,113 @@
+#include "swcore/dist_directory.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+#include <vector>
+
+namespace swcore {
+
+namespace {
+
+// Where file systems are case-insensitive by default, a name differing from
+// the listing only in case still resolves, as QFileInfo::exists() did.
+#if defined(Q_OS_WIN) || defined(Q_OS_DARWIN)
+constexpr bool kFoldCase = true;
+#else
+constexpr bool kFoldCase = false;
+#endif
+
+// Two non-empty parts around a single dot, the shape of a subproduct base.
+bool isSubproductName(const QByteArray &name) {
+    const int dot = name.indexOf('.');
+    return dot > 0 && dot < name.size() - 1 && name.indexOf('.', dot + 1) < 0;
+}
+
+} // namespace
+
+DistDirectory::DistDirectory(const QString &path) : m_path(path) {
+    refresh();
+}
+
+bool DistDirectory::refresh() {
+    m_names.clear();
+    m_foldedNames.clear();
+    m_products.clear();
+
+    const QDir dir(m_path);
+    m_valid = !m_path.isEmpty() && dir.exists();
+    if (!m_valid) {
+        return false;
+    }
+
+    const QFileInfoList infos =
+        dir.entryInfoList(QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot, QDir::Name);
+    m_names.reserve(infos.size());
+    for (const QFileInfo &fi : infos) {
+        const QString name = fi.fileName();
+        // idb references are Latin-1, so other names can never match.
+        const QByteArray latin1 = name.toLatin1();
+        if (QString::fromLatin1(latin1) == name) {
+            m_names.insert(latin1);
+            if (kFoldCase) {
+                m_foldedNames.insert(latin1.toLower());
+            }
+        }
+        // Hidden entries count as subproducts but not as products.
+        if (!fi.isHidden() && fi.isFile() && name.endsWith(".idb", Qt::CaseInsensitive)) {
+            m_products.push_back(fi.completeBaseName());
+        }
+    }
+    return true;
+}
+
+bool DistDirectory::isValid() const {
+    return m_valid;
+}
+
+const QString &DistDirectory::path() const {
+    return m_path;
+}
+
+QString DistDirectory::filePath(const QString &name) const {
+    return QDir(m_path).filePath(name);
+}
+
+bool DistDirectory::contains(const QString &name) const {
+    const QByteArray latin1 = name.toLatin1();
+    return contains(latin1.constData(), latin1.size());
+}
+
+bool DistDirectory::contains(const char *latin1, int size) const {
+    const QByteArray key = QByteArray::fromRawData(latin1, size);
+    if (m_names.contains(key)) {
+        return true;
+    }
+    return kFoldCase && !m_foldedNames.isEmpty() && m_foldedNames.contains(key.toLower());
+}
+
+const QStringList &DistDirectory::products() const {
+    return m_products;
+}
+
+QByteArray DistDirectory::subproductFingerprint() const {
+    const QSet<QByteArray> &names = kFoldCase ? m_foldedNames : m_names;
+    std::vector<QByteArray> sorted;
+    sorted.reserve(size_t(names.size()));
+    for (const QByteArray &name : names) {
+        if (isSubproductName(name)) {
+            sorted.push_back(name);
+        }
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    for (const QByteArray &name : sorted) {
+        hash.addData(name.constData(), name.size() + 1);
+    }
+    return hash.result();
+}
+
+} // namespace swcore
@@ -0,0 +1,100 @@
+#include "swcore/entry_store.h"
+
+#include <QHash>
+
+namespace swcore {
+
+EntryStore::EntryStore(QVector<FileEntry> entries) : m_entries(std::move(entries)) {
+    const size_t n = size_t(m_entries.size());
+    m_ftype.reserve(n);
+    m_mode.reserve(n);
+    m_size.reserve(n);
+    m_cmpsize.reserve(n);
+    m_payloadSize.reserve(n);
+    m_offset.reserve(n);
+    m_pathOffset.reserve(n);
+    m_pathLength.reserve(n);
+    m_parentLength.reserve(n);
+    m_lowerOffset.reserve(n);
+    m_lowerLength.reserve(n);
+    m_subgroup.reserve(n);
+
+    qsizetype arenaSize = 0;
+    for (const FileEntry &e : m_entries) {
+        arenaSize += e.fname.size();
+    }
+    m_paths.reserve(arenaSize);
+
+    QHash<QString, quint32> subgroupIds;
+    for (const FileEntry &e : m_entries) {
+        m_ftype.push_back(e.ftype.toLatin1());
+        m_mode.push_back(e.mode);
+        m_size.push_back(e.size);
+        m_cmpsize.push_back(e.cmpsize);
+        m_payloadSize.push_back(e.payloadSize);
+        m_offset.push_back(e.offset);
+
+        const QString path = normalizedPath(e.fname);
+        const int slash = path.lastIndexOf('/');
+        m_pathOffset.push_back(quint32(m_paths.size()));
+        m_pathLength.push_back(quint32(path.size()));
+        m_parentLength.push_back(quint32(slash < 0 ? 0 : slash));
+        m_paths += path;
+
+        const QString lower = path.mid(slash + 1).toLower();
+        m_lowerOffset.push_back(quint32(m_lowerNames.size()));
+        m_lowerLength.push_back(quint32(lower.size()));
+        m_lowerNames += lower;
+
+        auto it = subgroupIds.constFind(e.subgroup);
+        if (it == subgroupIds.constEnd()) {
+            it = subgroupIds.insert(e.subgroup, quint32(m_subgroups.size()));
+            m_subgroups.push_back(e.subgroup);
+        }
+        m_subgroup.push_back(it.value());
+    }
+}
+
+QStringView EntryStore::path(int i) const {
+    return QStringView(m_paths).mid(m_pathOffset[size_t(i)], m_pathLength[size_t(i)]);
+}
+
+QStringView EntryStore::parentPath(int i) const {
+    return QStringView(m_paths).mid(m_pathOffset[size_t(i)], m_parentLength[size_t(i)]);
+}
+
+QStringView EntryStore::baseName(int i) const {
+    const quint32 parent = m_parentLength[size_t(i)];
+    const quint32 start = parent == 0 ? 0 : parent + 1;
+    return path(i).mid(start);
+}
+
+QStringView EntryStore::baseNameLower(int i) const {
+    return QStringView(m_lowerNames).mid(m_lowerOffset[size_t(i)], m_lowerLength[size_t(i)]);
+}
+
+QString EntryStore::normalizedPath(const QString &path) {
+    QString p = path;
+    p.replace('\\', '/');
+    while (p.startsWith('/')) {
+        p.remove(0, 1);
+    }
+
+    QStringList out;
+    const QStringList segs = p.split('/', Qt::SkipEmptyParts);
+    for (const QString &seg : segs) {
+        if (seg == ".") {
+            continue;
+        }
+        if (seg == "..") {
+            if (!out.isEmpty()) {
+                out.removeLast();
+            }
+            continue;
+        }
+        out.push_back(seg);
+    }
+    return out.join('/');
+}
+
+} // namespace swcore
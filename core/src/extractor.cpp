@@ -1,17 +1,25 @@
 #include "swcore/extractor.h"
 
-#include <QDir>
-#include <QFile>
-#include <QFileInfo>
-#include <QFileDevice>
-#include <QPair>
-#include <QSaveFile>
+#include "swcore/dist_directory.h"
+#include "swcore/idb_parser.h"
+#include "swcore/lzw.h"
+#include "swcore/output_tree.h"
+#include "swcore/payload_map.h"
+#include "swcore/subproduct_file.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSemaphore>
 #include <QSet>
+#include <QThread>
+#include <QThreadPool>
 
 #include <algorithm>
+#include <atomic>
 #include <map>
 #include <memory>
-#include <optional>
 #include <stdexcept>
 #include <utility>
 #include <vector>
@@ -20,196 +28,9 @@ namespace swcore {
 
 namespace {
 
-class CompressCodeReader {
-public:
-    explicit CompressCodeReader(QByteArray data) : m_data(std::move(data)) {}
-
-    int nextCode(int maxBits, int maxMaxCode, int *nBits, int *maxCode, int freeEnt, bool *clearFlag) {
-        if (!nBits || !maxCode || !clearFlag) {
-            return -1;
-        }
-
-        if (*clearFlag || m_offset >= m_size || freeEnt > *maxCode) {
-            if (freeEnt > *maxCode) {
-                ++(*nBits);
-                if (*nBits == maxBits) {
-                    *maxCode = maxMaxCode;
-                } else {
-                    *maxCode = (1 << *nBits) - 1;
-                }
-            }
-
-            if (*clearFlag) {
-                *nBits = 9;
-                *maxCode = (1 << *nBits) - 1;
-                *clearFlag = false;
-            }
-
-            const int remain = m_data.size() - m_pos;
-            if (remain <= 0) {
-                return -1;
-            }
-
-            const int chunkBytes = std::min(*nBits, remain);
-            m_chunk = m_data.mid(m_pos, chunkBytes);
-            m_pos += chunkBytes;
-
-            m_offset = 0;
-            m_size = (chunkBytes << 3) - (*nBits - 1);
-            if (m_size <= 0) {
-                return -1;
-            }
-        }
-
-        if (m_offset >= m_size) {
-            return -1;
-        }
-
-        const int startBit = m_offset;
-        const int endBit = startBit + *nBits - 1;
-        const int endByte = endBit >> 3;
-        if (endByte >= m_chunk.size()) {
-            return -1;
-        }
-
-        static constexpr quint32 rmask[9] = {
-            0x00, 0x01, 0x03, 0x07, 0x0F, 0x1F, 0x3F, 0x7F, 0xFF
-        };
-
-        int bitOffset = startBit & 7;
-        int bitsLeft = *nBits;
-        const uchar *bp = reinterpret_cast<const uchar *>(m_chunk.constData()) + (startBit >> 3);
-
-        quint32 code = quint32(*bp++ >> bitOffset);
-        bitsLeft -= 8 - bitOffset;
-        int shift = 8 - bitOffset;
-
-        while (bitsLeft >= 8) {
-            code |= quint32(*bp++) << shift;
-            shift += 8;
-            bitsLeft -= 8;
-        }
-
-        if (bitsLeft > 0) {
-            code |= (quint32(*bp) & rmask[bitsLeft]) << shift;
-        }
-
-        m_offset += *nBits;
-        return int(code);
-    }
-
-private:
-    QByteArray m_data;
-    int m_pos = 0;
-    QByteArray m_chunk;
-    int m_offset = 0;
-    int m_size = 0;
-};
-
-QByteArray unlzw(const QByteArray &input) {
-    if (input.size() < 3 || quint8(input.at(0)) != 0x1F || quint8(input.at(1)) != 0x9D) {
-        throw std::runtime_error("Not a .Z stream");
-    }
-
-    const int flags = quint8(input.at(2));
-    const int maxbits = flags & 0x1F;
-    const bool blockMode = (flags & 0x80) != 0;
-    if (maxbits < 9 || maxbits > 16) {
-        throw std::runtime_error("Unsupported .Z maxbits");
-    }
-
-    const int clearCode = 256;
-    const int firstCode = 257;
-    const int maxMaxCode = 1 << maxbits;
-
-    int nBits = 9;
-    int maxCode = (1 << nBits) - 1;
-    int freeEnt = blockMode ? firstCode : 256;
-    bool clearFlag = false;
-
-    CompressCodeReader reader(input.mid(3));
-
-    std::vector<int> prefix(maxMaxCode, 0);
-    std::vector<quint8> suffix(maxMaxCode, 0);
-    std::vector<quint8> stack(maxMaxCode, 0);
-    for (int i = 0; i < 256; ++i) {
-        suffix[i] = quint8(i);
-    }
-
-    QByteArray output;
-
-    int oldCode = -1;
-    quint8 finChar = 0;
-
-    while (true) {
-        int code = reader.nextCode(maxbits, maxMaxCode, &nBits, &maxCode, freeEnt, &clearFlag);
-        if (code < 0) {
-            break;
-        }
-
-        if (blockMode && code == clearCode) {
-            clearFlag = true;
-            freeEnt = firstCode;
-            oldCode = -1;
-            continue;
-        }
-
-        if (oldCode < 0) {
-            if (code > 255) {
-                throw std::runtime_error("Corrupt .Z stream");
-            }
-            finChar = quint8(code);
-            output.append(char(finChar));
-            oldCode = code;
-            continue;
-        }
-
-        const int inCode = code;
-        int stackTop = 0;
-
-        if (code >= freeEnt) {
-            if (code != freeEnt) {
-                throw std::runtime_error("LZW decode error");
-            }
-            if (stackTop >= int(stack.size())) {
-                throw std::runtime_error("LZW stack overflow");
-            }
-            stack[stackTop++] = finChar;
-            code = oldCode;
-        }
-
-        while (code >= 256) {
-            if (code >= freeEnt || code < 0) {
-                throw std::runtime_error("LZW decode error");
-            }
-            if (stackTop >= int(stack.size())) {
-                throw std::runtime_error("LZW stack overflow");
-            }
-            stack[stackTop++] = suffix[code];
-            code = prefix[code];
-        }
-
-        finChar = quint8(code & 0xFF);
-        if (stackTop >= int(stack.size())) {
-            throw std::runtime_error("LZW stack overflow");
-        }
-        stack[stackTop++] = finChar;
-
-        while (stackTop > 0) {
-            output.append(char(stack[--stackTop]));
-        }
-
-        if (freeEnt < maxMaxCode) {
-            prefix[freeEnt] = oldCode;
-            suffix[freeEnt] = finChar;
-            ++freeEnt;
-        }
-
-        oldCode = inCode;
-    }
-
-    return output;
-}
+constexpr qint64 kStreamChunk = 256 * 1024;
+// Payload bytes kept under readahead ahead of the job being run.
+constexpr qint64 kReadAhead = 8 * 1024 * 1024;
 
 QString sanitizeRelativePath(QString p) {
     while (p.startsWith('/')) {
@@ -227,116 +48,22 @@ QString sanitizeRelativePath(QString p) {
     return clean.join('/');
 }
 
-bool ensureParentDir(const QString &path) {
-    return QDir().mkpath(QFileInfo(path).path());
-}
-
-QFileDevice::Permissions modeToPermissions(int mode) {
-    QFileDevice::Permissions p;
-    if (mode & 0400) p |= QFileDevice::ReadOwner;
-    if (mode & 0200) p |= QFileDevice::WriteOwner;
-    if (mode & 0100) p |= QFileDevice::ExeOwner;
-    if (mode & 0040) p |= QFileDevice::ReadGroup;
-    if (mode & 0020) p |= QFileDevice::WriteGroup;
-    if (mode & 0010) p |= QFileDevice::ExeGroup;
-    if (mode & 0004) p |= QFileDevice::ReadOther;
-    if (mode & 0002) p |= QFileDevice::WriteOther;
-    if (mode & 0001) p |= QFileDevice::ExeOther;
-    return p;
-}
-
-QList<QByteArray> nameVariants(const QString &name) {
-    const QByteArray raw = name.toLatin1();
-    QList<QByteArray> variants;
-    variants << raw << ("./" + raw) << ("/" + raw);
-
-    QList<QByteArray> unique;
-    QSet<QByteArray> seen;
-    for (const QByteArray &v : variants) {
-        if (!seen.contains(v)) {
-            unique.push_back(v);
-            seen.insert(v);
-        }
-    }
-    return unique;
-}
-
-bool checkHeaderAt(QFile &file, qint64 offset, const QByteArray &nameBytes) {
-    if (offset < 0 || !file.seek(offset)) {
-        return false;
-    }
-    const QByteArray hdr = file.read(nameBytes.size() + 2);
-    if (hdr.size() != nameBytes.size() + 2) {
-        return false;
-    }
-    const quint16 declaredLen = (quint16(quint8(hdr.at(0))) << 8) | quint16(quint8(hdr.at(1)));
-    return declaredLen == quint16(nameBytes.size()) && hdr.mid(2) == nameBytes;
-}
-
-std::optional<QPair<qint64, QByteArray>> resyncOffset(QFile &file,
-                                                       const QList<QByteArray> &variants,
-                                                       qint64 baseOffset,
-                                                       qint64 back,
-                                                       qint64 forward,
-                                                       qint64 chunkSize) {
-    if (variants.isEmpty()) {
-        return std::nullopt;
-    }
-
-    const qint64 scanStart = std::max<qint64>(0, baseOffset - back);
-    const qint64 scanEnd = std::min(file.size(), baseOffset + forward);
-    if (scanStart >= scanEnd) {
-        return std::nullopt;
-    }
-
-    int maxNameLen = 0;
-    for (const QByteArray &v : variants) {
-        maxNameLen = std::max(maxNameLen, int(v.size()));
-    }
-    const qint64 overlap = maxNameLen + 2;
-    qint64 pos = scanStart;
-
-    while (pos < scanEnd) {
-        const qint64 toRead = std::min(chunkSize, scanEnd - pos);
-        if (!file.seek(pos)) {
-            return std::nullopt;
-        }
-        const QByteArray blob = file.read(toRead);
-        if (blob.isEmpty()) {
-            break;
-        }
-
-        for (const QByteArray &name : variants) {
-            int found = blob.indexOf(name);
-            while (found >= 0) {
-                if (found >= 2) {
-                    const qint64 candidate = pos + found - 2;
-                    if (checkHeaderAt(file, candidate, name)) {
-                        return QPair<qint64, QByteArray>(candidate, name);
-                    }
-                }
-                found = blob.indexOf(name, found + 1);
-            }
-        }
-
-        if (toRead <= overlap) {
-            break;
-        }
-        pos += toRead - overlap;
-    }
-
-    return std::nullopt;
+QString parentOf(const QString &relPath) {
+    const int slash = relPath.lastIndexOf('/');
+    return slash < 0 ? QString() : relPath.left(slash);
 }
 
+// An open subproduct file with its payload map for this run.
 struct SubRuntime {
-    explicit SubRuntime(QString path) : filePath(std::move(path)), file(filePath) {}
+    explicit SubRuntime(const QString &path) : file(path) {}
 
-    QString filePath;
-    QFile file;
-    qint64 delta = 0;
+    SubproductFile file;
+    PayloadMap map;
+    // Why a record left out of the map could not be located, by idb offset.
+    QHash<qint64, QString> locateErrors;
 };
 
-SubRuntime *ensureSubRuntime(const QString &distDirPath,
+SubRuntime *ensureSubRuntime(const DistDirectory &dist,
                              const QString &subBase,
                              std::map<QString, std::unique_ptr<SubRuntime>> *subs,
                              QString *error) {
@@ -348,343 +75,1044 @@ SubRuntime *ensureSubRuntime(const QString &distDirPath,
         return it->second.get();
     }
 
-    const QString subPath = QDir(distDirPath).filePath(subBase);
+    const QString subPath = dist.filePath(subBase);
+    if (!dist.contains(subBase)) {
+        if (error) {
+            *error = QString("Missing subproduct file: %1").arg(subPath);
+        }
+        return nullptr;
+    }
     auto runtime = std::make_unique<SubRuntime>(subPath);
-    if (!runtime->file.open(QIODevice::ReadOnly)) {
+    if (!runtime->file.open()) {
         if (error) {
             *error = QString("Cannot open subproduct file: %1").arg(subPath);
         }
         return nullptr;
     }
+    runtime->file.adviseSequential();
 
     const auto inserted = subs->emplace(subBase, std::move(runtime));
     return inserted.first->second.get();
 }
 
-bool readPayload(SubRuntime *sub,
-                 const FileEntry &entry,
-                 const ExtractOptions &options,
-                 QByteArray *payload,
-                 QString *error) {
-    if (!sub || !payload) {
+bool locatePayload(SubRuntime *sub, const FileEntry &entry, qint64 *dataOffset, QString *error) {
+    if (!sub || !dataOffset) {
         if (error) {
             *error = "Internal error reading payload";
         }
         return false;
     }
-    if (entry.payloadSize < 0 || entry.offset < 0) {
+    const PayloadMap::Location *location = sub->map.find(entry);
+    if (!location) {
         if (error) {
-            *error = "Invalid payload metadata";
+            *error = sub->locateErrors.value(entry.offset, "Payload was not located");
         }
         return false;
     }
+    *dataOffset = location->data;
+    return true;
+}
 
-    QFile &file = sub->file;
-    const QList<QByteArray> variants = nameVariants(entry.fname);
-    qint64 wantOff = entry.offset + sub->delta;
-    QByteArray matched;
-
-    for (const QByteArray &name : variants) {
-        if (checkHeaderAt(file, wantOff, name)) {
-            matched = name;
-            break;
-        }
+// Readahead for the payload of an entry that is still ahead of the reads;
+// returns the bytes advised.
+qint64 adviseEntry(const FileEntry &entry, const std::map<QString, std::unique_ptr<SubRuntime>> &subs) {
+    if (entry.ftype != 'f' || entry.payloadSize <= 0) {
+        return 0;
     }
+    const auto it = subs.find(entry.subproductBase);
+    if (it == subs.end()) {
+        return 0;
+    }
+    const PayloadMap::Location *location = it->second->map.find(entry);
+    if (!location) {
+        return 0;
+    }
+    it->second->file.willNeed(location->data, entry.payloadSize);
+    return entry.payloadSize;
+}
 
-    if (matched.isEmpty()) {
-        const auto res = resyncOffset(file,
-                                      variants,
-                                      wantOff,
-                                      options.resyncBack,
-                                      options.resyncForward,
-                                      std::max<qint64>(4096, options.resyncChunk));
-        if (!res.has_value() && sub->delta != 0) {
-            for (const QByteArray &name : variants) {
-                if (checkHeaderAt(file, entry.offset, name)) {
-                    sub->delta = 0;
-                    wantOff = entry.offset;
-                    matched = name;
-                    break;
-                }
+// Keeps WILLNEED advice up to kReadAhead bytes ahead of the item being read
+// in a sequence of payloads. Items must be visited in increasing order;
+// skipped items just drop out of the window.
+class ReadAheadWindow {
+public:
+    explicit ReadAheadWindow(size_t count) : m_sizes(count, 0) {}
+
+    // Called before item current is read; advise(k) hints item k and
+    // returns its size.
+    template <typename Advise>
+    void moveTo(int current, const Advise &advise) {
+        for (; m_pos <= current && m_pos < m_next; ++m_pos) {
+            m_ahead -= m_sizes[size_t(m_pos)];
+        }
+        m_pos = std::max(m_pos, current + 1);
+        m_next = std::max(m_next, current);
+        while (m_next < int(m_sizes.size()) && (m_next <= current || m_ahead < kReadAhead)) {
+            m_sizes[size_t(m_next)] = advise(m_next);
+            if (m_next > current) {
+                m_ahead += m_sizes[size_t(m_next)];
             }
+            ++m_next;
         }
+    }
 
-        if (matched.isEmpty()) {
-            if (!res.has_value()) {
-                if (error) {
-                    *error = QString("Out of sync at %1 (delta=%2)")
-                                 .arg(entry.offset)
-                                 .arg(sub->delta);
-                }
-                return false;
-            }
+private:
+    std::vector<qint64> m_sizes;
+    // Items in [m_pos, m_next) are advised and counted in m_ahead.
+    int m_pos = 0;
+    int m_next = 0;
+    qint64 m_ahead = 0;
+};
+
+// Per-run counters, updated from every thread taking part in the run.
+// Phase times are summed over threads.
+struct Metrics {
+    std::atomic<qint64> bytesWritten{0};
+    std::atomic<qint64> locateNs{0};
+    std::atomic<qint64> readNs{0};
+    std::atomic<qint64> decodeNs{0};
+    std::atomic<qint64> writeNs{0};
+    std::atomic<qint64> chmodNs{0};
+};
+
+// Adds the time spent in its scope to one of the Metrics phase counters.
+class PhaseTimer {
+public:
+    explicit PhaseTimer(std::atomic<qint64> &counter) : m_counter(counter) { m_timer.start(); }
+    ~PhaseTimer() { m_counter.fetch_add(m_timer.nsecsElapsed(), std::memory_order_relaxed); }
+
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+    std::atomic<qint64> &m_counter;
+    QElapsedTimer m_timer;
+};
+
+// Calls the byte progress callback on the thread driving the run, at most
+// every kReportIntervalMs, and turns a false return into a cancel.
+class ByteReporter {
+public:
+    static constexpr qint64 kReportIntervalMs = 50;
+
+    ByteReporter(const DistExtractor::ByteProgressCallback &callback, ExtractProgress *state)
+        : m_callback(callback), m_state(state) {}
 
-            const qint64 candidate = res->first;
-            matched = res->second;
-            const qint64 newDelta = candidate - entry.offset;
-            sub->delta = newDelta;
-            wantOff = candidate;
+    void poll(bool force = false) {
+        if (!m_callback || (!force && m_timer.isValid() && m_timer.elapsed() < kReportIntervalMs)) {
+            return;
+        }
+        m_timer.start();
+        DistExtractor::ByteProgress progress;
+        progress.bytesDone = m_state->bytesDone();
+        progress.bytesTotal = m_state->bytesTotal();
+        progress.entriesDone = m_state->entriesDone();
+        progress.entriesTotal = m_state->entriesTotal();
+        progress.currentFile = m_state->currentFile();
+        if (!m_callback(progress)) {
+            m_state->cancel();
         }
     }
 
-    if (!file.seek(wantOff + 2 + matched.size())) {
+private:
+    const DistExtractor::ByteProgressCallback &m_callback;
+    ExtractProgress *m_state = nullptr;
+    QElapsedTimer m_timer;
+};
+
+// Where the stages of a run report to and write into. The reporter is only
+// set on the thread that drives the run.
+struct RunContext {
+    ExtractProgress *state = nullptr;
+    Metrics *metrics = nullptr;
+    ByteReporter *reporter = nullptr;
+    OutputTree *output = nullptr;
+};
+
+bool openOutput(OutputFile *out, const RunContext &run, QString *error) {
+    PhaseTimer timer(run.metrics->writeNs);
+    return out->open(error);
+}
+
+bool writeChunk(OutputFile *out, const char *data, qint64 size, const RunContext &run, QString *error) {
+    PhaseTimer timer(run.metrics->writeNs);
+    if (!out->write(data, size)) {
         if (error) {
-            *error = QString("Seek failed at %1").arg(wantOff);
+            *error = QString("Write failed for %1").arg(out->fileName());
         }
         return false;
     }
+    run.metrics->bytesWritten.fetch_add(size, std::memory_order_relaxed);
+    return true;
+}
 
-    const QByteArray data = file.read(entry.payloadSize);
-    if (data.size() != entry.payloadSize) {
+bool commitOutput(OutputFile *out, int mode, bool applyMode, const RunContext &run, QString *error) {
+    if (applyMode) {
+        PhaseTimer timer(run.metrics->chmodNs);
+        out->setMode(mode);
+    }
+    PhaseTimer timer(run.metrics->writeNs);
+    if (!out->commit()) {
         if (error) {
-            *error = QString("Short read for %1").arg(entry.fname);
+            *error = QString("Commit failed for %1").arg(out->fileName());
         }
         return false;
     }
-    *payload = data;
     return true;
 }
 
-bool writeBytes(const QString &path, const QByteArray &bytes, int mode, QString *error, bool applyMode = true) {
-    if (!ensureParentDir(path)) {
+bool writeBytes(const QString &relPath,
+                const QByteArray &bytes,
+                int mode,
+                const RunContext &run,
+                QString *error,
+                bool applyMode = true) {
+    OutputFile out(run.output, relPath);
+    return openOutput(&out, run, error) && writeChunk(&out, bytes.constData(), bytes.size(), run, error) &&
+           commitOutput(&out, mode, applyMode, run, error);
+}
+
+// Streams a located payload from the subproduct file into the .Z temp and,
+// when rawOut is set, through the LZW decoder into the output file. Mapped
+// payloads are handed over as views; otherwise memory use is bounded by
+// kStreamChunk regardless of the payload size. Progress is reported and
+// cancellation checked once per buffer; a stop sets *canceled. A corrupt .Z
+// stream sets *decodeFailed but still completes the .Z copy.
+bool pipePayload(SubproductFile &file,
+                 const FileEntry &entry,
+                 qint64 dataOffset,
+                 OutputFile *zOut,
+                 OutputFile *rawOut,
+                 const RunContext &run,
+                 bool *decodeFailed,
+                 bool *canceled,
+                 QString *error) {
+    LzwDecoder decoder;
+    std::vector<char> outBuf;
+
+    qint64 reported = 0;
+    auto report = [&](qint64 upTo) {
+        upTo = std::min(upTo, entry.payloadSize);
+        if (upTo > reported) {
+            run.state->addBytes(upTo - reported);
+            reported = upTo;
+        }
+        if (run.reporter) {
+            run.reporter->poll();
+        }
+    };
+    auto stopRequested = [&]() {
+        if (!run.state->isCanceled()) {
+            return false;
+        }
+        *canceled = true;
         if (error) {
-            *error = QString("Cannot create parent directory for %1").arg(path);
+            *error = "Canceled";
         }
-        return false;
-    }
+        return true;
+    };
+
+    // A mapped payload is decoded in one piece, so its progress follows the
+    // decoded output against the size recorded in the idb.
+    auto decodeInto = [&](bool finished, bool reportOutput) -> bool {
+        try {
+            if (finished) {
+                decoder.finish();
+            }
+            qint64 written = 0;
+            for (;;) {
+                qint64 n = 0;
+                {
+                    PhaseTimer timer(run.metrics->decodeNs);
+                    n = decoder.drain(outBuf.data(), qint64(outBuf.size()));
+                }
+                if (n <= 0) {
+                    break;
+                }
+                if (!writeChunk(rawOut, outBuf.data(), n, run, error)) {
+                    return false;
+                }
+                written += n;
+                if (reportOutput && entry.size > 0) {
+                    report(qint64(double(entry.payloadSize) * double(written) / double(entry.size)));
+                }
+                if (stopRequested()) {
+                    return false;
+                }
+            }
+        } catch (const std::exception &) {
+            *decodeFailed = true;
+        }
+        return true;
+    };
 
-    QFileInfo fi(path);
-    if (fi.exists()) {
-        if (fi.isDir()) {
+    if (file.isMapped()) {
+        const char *payload = nullptr;
+        {
+            PhaseTimer timer(run.metrics->readNs);
+            payload = file.view(dataOffset, entry.payloadSize);
+        }
+        if (!payload) {
             if (error) {
-                *error = QString("Output path is a directory: %1").arg(path);
+                *error = QString("Short read for %1").arg(entry.fname);
             }
             return false;
         }
-        QFile existing(path);
-        QFileDevice::Permissions perms = existing.permissions();
-        perms |= QFileDevice::WriteOwner;
-        existing.setPermissions(perms);
+        const bool lzw = rawOut && isCompressStream(payload, entry.payloadSize);
+        for (qint64 pos = 0; pos < entry.payloadSize; pos += kStreamChunk) {
+            if (stopRequested()) {
+                return false;
+            }
+            const qint64 n = std::min(kStreamChunk, entry.payloadSize - pos);
+            if (zOut && !writeChunk(zOut, payload + pos, n, run, error)) {
+                return false;
+            }
+            if (rawOut && !lzw && !writeChunk(rawOut, payload + pos, n, run, error)) {
+                return false;
+            }
+            if (!lzw) {
+                report(pos + n);
+            }
+        }
+        if (lzw) {
+            outBuf.resize(size_t(kStreamChunk));
+            decoder.feedView(payload, entry.payloadSize);
+            if (!decodeInto(true, true)) {
+                return false;
+            }
+        }
+        report(entry.payloadSize);
+        return true;
     }
 
-    QSaveFile out(path);
-    if (!out.open(QIODevice::WriteOnly)) {
-        if (error) {
-            *error = QString("Cannot open output file %1").arg(path);
+    std::vector<char> inBuf(size_t(std::min(entry.payloadSize, kStreamChunk)));
+    bool firstChunk = true;
+    bool lzw = false;
+    qint64 pos = 0;
+
+    while (pos < entry.payloadSize) {
+        if (stopRequested()) {
+            return false;
         }
-        return false;
-    }
-    if (out.write(bytes) != bytes.size()) {
-        if (error) {
-            *error = QString("Write failed for %1").arg(path);
+        const qint64 want = std::min<qint64>(entry.payloadSize - pos, qint64(inBuf.size()));
+        qint64 got = 0;
+        {
+            PhaseTimer timer(run.metrics->readNs);
+            got = file.read(dataOffset + pos, inBuf.data(), want);
         }
-        return false;
-    }
-    if (!out.commit()) {
-        if (error) {
-            *error = QString("Commit failed for %1").arg(path);
+        if (got != want) {
+            if (error) {
+                *error = QString("Short read for %1").arg(entry.fname);
+            }
+            return false;
+        }
+        pos += want;
+        report(pos);
+
+        if (zOut && !writeChunk(zOut, inBuf.data(), want, run, error)) {
+            return false;
+        }
+        if (!rawOut || *decodeFailed) {
+            continue;
+        }
+
+        if (firstChunk) {
+            firstChunk = false;
+            lzw = isCompressStream(inBuf.data(), want);
+            if (lzw) {
+                outBuf.resize(size_t(kStreamChunk));
+            }
+        }
+        if (!lzw) {
+            if (!writeChunk(rawOut, inBuf.data(), want, run, error)) {
+                return false;
+            }
+            continue;
+        }
+
+        decoder.feed(inBuf.data(), want);
+        if (!decodeInto(pos == entry.payloadSize, false)) {
+            return false;
         }
-        return false;
-    }
-    if (applyMode) {
-        QFile(path).setPermissions(modeToPermissions(mode));
     }
     return true;
 }
 
-bool removeFileEvenIfReadonly(const QString &path) {
-    QFile f(path);
-    if (!f.exists()) {
-        return true;
-    }
-    QFileDevice::Permissions p = f.permissions();
-    p |= QFileDevice::WriteOwner;
-    f.setPermissions(p);
-    return f.remove();
+bool writeAndSetMode(const QString &relPath, const QByteArray &bytes, int mode, const RunContext &run, QString *error) {
+    return writeBytes(relPath, bytes, mode, run, error, true);
 }
 
-bool writeAndSetMode(const QString &path, const QByteArray &bytes, int mode, QString *error) {
-    return writeBytes(path, bytes, mode, error, true);
+bool writeSymlinkFallback(const QString &relPath, const QString &target, const RunContext &run, QString *error) {
+    return writeAndSetMode(relPath, target.toUtf8(), 0644, run, error);
 }
 
-bool writeTempBytes(const QString &path, const QByteArray &bytes, QString *error) {
-    // Temporary .Z payload should stay writable so cleanup can remove it on Windows.
-    return writeBytes(path, bytes, 0, error, false);
+bool writeEmptyFile(const QString &relPath, int mode, const RunContext &run, QString *error) {
+    return writeAndSetMode(relPath, QByteArray(), mode, run, error);
 }
 
-bool writeSymlinkFallback(const QString &path, const QString &target, QString *error) {
-    return writeAndSetMode(path, target.toUtf8(), 0644, error);
-}
+// A located file payload, ready to be decoded and written. Worker threads
+// read mapped subproducts through the shared view and reopen the file
+// otherwise.
+struct PayloadJob {
+    const FileEntry *entry = nullptr;
+    QString relPath;
+    SubproductFile *source = nullptr;
+    qint64 dataOffset = -1;
+};
 
-bool writeEmptyFile(const QString &path, int mode, QString *error) {
-    return writeAndSetMode(path, QByteArray(), mode, error);
-}
+enum class PayloadStatus {
+    Written,
+    Failed,
+    Canceled
+};
 
-bool writeExtractedFile(const QString &path, const QByteArray &raw, int mode, QString *error) {
-    return writeAndSetMode(path, raw, mode, error);
-}
+PayloadStatus writePayload(SubproductFile &src,
+                           const PayloadJob &job,
+                           const ExtractOptions &options,
+                           const RunContext &run,
+                           QString *error) {
+    const FileEntry &entry = *job.entry;
+    QString runtimeError;
 
-bool writeCompressedTemp(const QString &path, const QByteArray &payload, QString *error) {
-    return writeTempBytes(path, payload, error);
-}
+    // The .Z copy is only materialized when it is wanted as output. With
+    // keepZ it is written from the same payload buffer the decoder reads.
+    const bool decompress = !options.noDecompress;
+    const bool writeZ = options.keepZ || !decompress;
 
-bool removeCompressedTemp(const QString &path, QString *error) {
-    if (removeFileEvenIfReadonly(path)) {
-        return true;
+    OutputFile zOut(run.output, job.relPath + ".Z");
+    if (writeZ && !openOutput(&zOut, run, &runtimeError)) {
+        if (error) {
+            *error = runtimeError;
+        }
+        return PayloadStatus::Failed;
+    }
+
+    OutputFile rawOut(run.output, job.relPath);
+    if (decompress && !openOutput(&rawOut, run, &runtimeError)) {
+        if (error) {
+            *error = runtimeError;
+        }
+        return PayloadStatus::Failed;
+    }
+
+    bool decodeFailed = false;
+    bool canceled = false;
+    if (!pipePayload(src,
+                     entry,
+                     job.dataOffset,
+                     writeZ ? &zOut : nullptr,
+                     decompress ? &rawOut : nullptr,
+                     run,
+                     &decodeFailed,
+                     &canceled,
+                     &runtimeError)) {
+        if (error) {
+            *error = runtimeError;
+        }
+        return canceled ? PayloadStatus::Canceled : PayloadStatus::Failed;
     }
-    if (error) {
-        *error = QString("Cannot remove temp file %1").arg(path);
+
+    // Kept .Z files stay writable so later runs can overwrite them on Windows.
+    if (writeZ && !commitOutput(&zOut, 0, false, run, &runtimeError)) {
+        if (error) {
+            *error = runtimeError;
+        }
+        return PayloadStatus::Failed;
+    }
+
+    if (!decompress) {
+        return PayloadStatus::Written;
+    }
+
+    if (decodeFailed) {
+        if (error) {
+            *error = QString("LZW decompress failed: %1").arg(entry.fname);
+        }
+        return PayloadStatus::Failed;
+    }
+
+    if (!commitOutput(&rawOut, entry.mode, true, run, &runtimeError)) {
+        if (error) {
+            *error = runtimeError;
+        }
+        return PayloadStatus::Failed;
     }
-    return false;
+    return PayloadStatus::Written;
 }
 
-bool extractOne(const QString &distDirPath,
-                const QString &outDirPath,
-                const FileEntry &entry,
-                const ExtractOptions &options,
-                std::map<QString, std::unique_ptr<SubRuntime>> *subStates,
-                QString *error) {
+enum class EntryStep {
+    Done,
+    Failed,
+    NeedsPayload
+};
+
+// Handles everything that must stay in idb order on the calling thread:
+// directories, symlinks, empty files and the payload map lookup. File
+// payloads are returned in *job.
+EntryStep prepareOne(const DistDirectory &dist,
+                     const FileEntry &entry,
+                     const RunContext &run,
+                     std::map<QString, std::unique_ptr<SubRuntime>> *subStates,
+                     PayloadJob *job,
+                     QString *error) {
     const QString safeRel = sanitizeRelativePath(entry.fname);
-    const QString dstPath = safeRel.isEmpty() ? outDirPath : QDir(outDirPath).filePath(safeRel);
+    OutputTree *output = run.output;
 
     if (entry.ftype == 'd') {
-        if (!QDir().mkpath(dstPath)) {
+        bool created = false;
+        {
+            PhaseTimer timer(run.metrics->writeNs);
+            created = output->ensureDir(safeRel);
+        }
+        if (!created) {
             if (error) {
-                *error = QString("Cannot create directory %1").arg(dstPath);
+                *error = QString("Cannot create directory %1").arg(output->absolutePath(safeRel));
             }
-            return false;
+            return EntryStep::Failed;
         }
-        QFile(dstPath).setPermissions(modeToPermissions(entry.mode));
-        return true;
+        output->setDirMode(safeRel, entry.mode);
+        return EntryStep::Done;
     }
 
     if (entry.ftype == 'l') {
-        if (!ensureParentDir(dstPath)) {
-            if (error) {
-                *error = QString("Cannot create parent for symlink %1").arg(dstPath);
+        bool linked = false;
+        {
+            PhaseTimer timer(run.metrics->writeNs);
+            if (safeRel.isEmpty() || !output->ensureDir(parentOf(safeRel))) {
+                if (error) {
+                    *error = QString("Cannot create parent for symlink %1").arg(output->absolutePath(safeRel));
+                }
+                return EntryStep::Failed;
             }
-            return false;
+            linked = output->createSymlink(safeRel, entry.symval);
         }
-        QFile::remove(dstPath);
-        if (!QFile::link(entry.symval, dstPath)) {
-            const QString linkMeta = dstPath + ".link.txt";
-            return writeSymlinkFallback(linkMeta, entry.symval, error);
+        if (!linked) {
+            return writeSymlinkFallback(safeRel + ".link.txt", entry.symval, run, error) ? EntryStep::Done
+                                                                                           : EntryStep::Failed;
         }
-        return true;
+        return EntryStep::Done;
     }
 
     if (entry.ftype != 'f') {
-        return false;
+        return EntryStep::Failed;
     }
 
     if (entry.payloadSize == 0) {
-        return writeEmptyFile(dstPath, entry.mode, error);
+        return writeEmptyFile(safeRel, entry.mode, run, error) ? EntryStep::Done : EntryStep::Failed;
     }
 
+    PhaseTimer timer(run.metrics->locateNs);
     QString runtimeError;
-    SubRuntime *sub = ensureSubRuntime(distDirPath, entry.subproductBase, subStates, &runtimeError);
+    SubRuntime *sub = ensureSubRuntime(dist, entry.subproductBase, subStates, &runtimeError);
     if (!sub) {
         if (error) {
             *error = runtimeError;
         }
-        return false;
+        return EntryStep::Failed;
     }
 
-    QByteArray payload;
-    if (!readPayload(sub, entry, options, &payload, &runtimeError)) {
+    qint64 dataOffset = -1;
+    if (!locatePayload(sub, entry, &dataOffset, &runtimeError)) {
         if (error) {
             *error = runtimeError;
         }
-        return false;
+        return EntryStep::Failed;
     }
 
-    const QString zPath = dstPath + ".Z";
-    if (!writeCompressedTemp(zPath, payload, &runtimeError)) {
-        if (error) {
-            *error = runtimeError;
-        }
-        return false;
+    job->entry = &entry;
+    job->relPath = safeRel;
+    job->source = &sub->file;
+    job->dataOffset = dataOffset;
+    return EntryStep::NeedsPayload;
+}
+
+enum class EntryState {
+    NotRun,
+    Skipped,
+    Extracted,
+    Failed
+};
+
+// finished is set, with release order, once state and error are final, so
+// the driving thread can report entries while workers still run.
+struct EntryOutcome {
+    EntryState state = EntryState::NotRun;
+    QString error;
+    std::atomic<bool> finished{false};
+};
+
+// A payload interrupted by cancel() is left as NotRun rather than failed;
+// any other failure counts, even while a stop is pending.
+void recordPayload(PayloadStatus status, ExtractProgress *state, EntryOutcome *outcome, std::atomic<bool> *failed) {
+    if (status == PayloadStatus::Written) {
+        outcome->state = EntryState::Extracted;
+    } else if (status == PayloadStatus::Canceled) {
+        outcome->error.clear();
+    } else {
+        outcome->state = EntryState::Failed;
+        failed->store(true);
     }
+    state->finishEntry();
+    outcome->finished.store(true, std::memory_order_release);
+}
 
-    if (options.noDecompress) {
-        return true;
+class PayloadTask : public QRunnable {
+public:
+    PayloadTask(PayloadJob job,
+                const ExtractOptions &options,
+                RunContext run,
+                EntryOutcome *outcome,
+                QSemaphore *inFlight,
+                std::atomic<bool> *failed)
+        : m_job(std::move(job)),
+          m_options(options),
+          m_run(run),
+          m_outcome(outcome),
+          m_inFlight(inFlight),
+          m_failed(failed) {
+        m_run.reporter = nullptr;
     }
 
-    QByteArray raw = payload;
-    if (payload.size() >= 2 && quint8(payload.at(0)) == 0x1F && quint8(payload.at(1)) == 0x9D) {
-        try {
-            raw = unlzw(payload);
-        } catch (const std::exception &) {
-            if (error) {
-                *error = QString("LZW decompress failed: %1").arg(entry.fname);
+    void run() override {
+        QString error;
+        PayloadStatus status = PayloadStatus::Failed;
+        if (m_job.source->isMapped()) {
+            status = writePayload(*m_job.source, m_job, m_options, m_run, &error);
+        } else {
+            SubproductFile src(m_job.source->path());
+            if (!src.open()) {
+                error = QString("Cannot open subproduct file: %1").arg(src.path());
+            } else {
+                src.adviseSequential();
+                status = writePayload(src, m_job, m_options, m_run, &error);
             }
-            return false;
         }
+        m_outcome->error = error;
+        recordPayload(status, m_run.state, m_outcome, m_failed);
+        m_inFlight->release();
     }
 
-    if (!writeExtractedFile(dstPath, raw, entry.mode, &runtimeError)) {
-        if (error) {
-            *error = runtimeError;
+private:
+    PayloadJob m_job;
+    const ExtractOptions &m_options;
+    RunContext m_run;
+    EntryOutcome *m_outcome = nullptr;
+    QSemaphore *m_inFlight = nullptr;
+    std::atomic<bool> *m_failed = nullptr;
+};
+
+// Every record stored in the subproduct file, from the idb of its product
+// (named by the subgroup's first part), plus any of the run's entries that
+// idb no longer lists. Without a readable idb only the run's entries are
+// walked, and the gaps between them are stepped over by idb offset.
+QVector<const FileEntry *> chainEntries(const DistDirectory &dist,
+                                        const QString &subBase,
+                                        const QVector<const FileEntry *> &selected,
+                                        const ExtractOptions &options,
+                                        std::map<QString, ParseResult> *idbs) {
+    const QString product = subBase.section('.', 0, 0);
+    auto it = idbs->find(product);
+    if (it == idbs->end()) {
+        ParseResult parsed;
+        QString error;
+        if (dist.contains(product + ".idb")) {
+            parsed = options.cachePayloadMaps ? IdbParser::parseCached(dist, product, QString(), &error)
+                                              : IdbParser::parse(dist, product, &error);
         }
-        return false;
+        it = idbs->emplace(product, std::move(parsed)).first;
     }
 
-    if (!options.keepZ) {
-        if (!removeCompressedTemp(zPath, &runtimeError)) {
-            if (error) {
-                *error = runtimeError;
+    QVector<const FileEntry *> chain;
+    QSet<qint64> offsets;
+    for (const FileEntry &entry : it->second.entries) {
+        if (entry.ftype == 'f' && entry.subproductBase == subBase) {
+            chain.push_back(&entry);
+            offsets.insert(entry.offset);
+        }
+    }
+    for (const FileEntry *entry : selected) {
+        if (!offsets.contains(entry->offset)) {
+            chain.push_back(entry);
+        }
+    }
+    return chain;
+}
+
+// Maps the payload records of each subproduct file the run reads from,
+// starting from the cached map when it still covers the run's entries.
+// Files that cannot be opened are left for prepareOne() to report.
+void mapPayloads(const DistDirectory &dist,
+                 const QVector<FileEntry> &entries,
+                 const ExtractOptions &options,
+                 const RunContext &run,
+                 std::map<QString, std::unique_ptr<SubRuntime>> *subStates) {
+    PhaseTimer timer(run.metrics->locateNs);
+    std::map<QString, QVector<const FileEntry *>> bySub;
+    for (const FileEntry &entry : entries) {
+        if (entry.ftype == 'f' && entry.payloadSize > 0) {
+            bySub[entry.subproductBase].push_back(&entry);
+        }
+    }
+
+    QString cacheDir;
+    if (options.cachePayloadMaps) {
+        cacheDir = options.payloadMapDir.isEmpty() ? PayloadMap::defaultDirectory() : options.payloadMapDir;
+    }
+    std::map<QString, ParseResult> idbs;
+    for (const auto &group : bySub) {
+        if (run.state->isCanceled()) {
+            return;
+        }
+        SubRuntime *sub = ensureSubRuntime(dist, group.first, subStates, nullptr);
+        if (!sub) {
+            continue;
+        }
+        if (!cacheDir.isEmpty()) {
+            sub->map = PayloadMap::load(cacheDir, sub->file);
+        }
+        if (!sub->map.covers(sub->file, group.second)) {
+            const QVector<const FileEntry *> chain = chainEntries(dist, group.first, group.second, options, &idbs);
+            sub->map.walkChain(sub->file, chain, options, &sub->locateErrors);
+            if (!cacheDir.isEmpty()) {
+                sub->map.store(cacheDir, sub->file);
             }
-            return false;
+        }
+        if (run.reporter) {
+            run.reporter->poll();
         }
     }
-    return true;
 }
 
-} // namespace
+int workerCount(const ExtractOptions &options) {
+    if (options.workers > 0) {
+        return options.workers;
+    }
+    return std::max(1, QThread::idealThreadCount());
+}
 
-ExtractResult DistExtractor::extract(const QString &distDirPath,
-                                     const QVector<FileEntry> &entries,
-                                     const QString &outDirPath,
-                                     const ExtractOptions &options,
-                                     const ProgressCallback &progress) {
+// Which payloads the offset-ordered plan can run late without changing what
+// a run in input order leaves behind.
+struct WriteOrder {
+    // Payloads that a later file or symlink at the same path replaces; they
+    // are skipped instead of written.
+    std::vector<char> superseded;
+    // Set when reordering could change the result: a later entry makes a
+    // directory at a payload's path, or a file or symlink sits at a path a
+    // payload needs as a directory while that payload could run before it.
+    bool inputOrder = false;
+};
+
+WriteOrder planWriteOrder(const QVector<FileEntry> &entries) {
+    WriteOrder order;
+    order.superseded.assign(size_t(entries.size()), 0);
+
+    const auto isPayload = [](const FileEntry &e) { return e.ftype == 'f' && e.payloadSize > 0; };
+    struct PathWriters {
+        int lastDir = -1;
+        int lastOther = -1;
+        bool payload = false;
+    };
+    std::vector<QString> paths(size_t(entries.size()));
+    QHash<QString, PathWriters> writers;
+    for (int i = 0; i < entries.size(); ++i) {
+        const FileEntry &e = entries.at(i);
+        if (e.ftype != 'f' && e.ftype != 'd' && e.ftype != 'l') {
+            continue;
+        }
+        paths[size_t(i)] = sanitizeRelativePath(e.fname);
+        PathWriters &w = writers[paths[size_t(i)]];
+        if (e.ftype == 'd') {
+            w.lastDir = i;
+        } else {
+            w.lastOther = i;
+            w.payload = w.payload || isPayload(e);
+        }
+    }
+
+    for (int i = 0; i < entries.size(); ++i) {
+        if (!isPayload(entries.at(i))) {
+            continue;
+        }
+        const QString &path = paths[size_t(i)];
+        const PathWriters self = writers.value(path);
+        if (self.lastDir > i) {
+            order.inputOrder = true;
+            return order;
+        }
+        order.superseded[size_t(i)] = self.lastOther > i ? 1 : 0;
+        for (int slash = path.lastIndexOf('/'); slash > 0; slash = path.lastIndexOf('/', slash - 1)) {
+            const auto it = writers.constFind(path.left(slash));
+            if (it != writers.constEnd() && (it->lastOther > i || it->payload)) {
+                order.inputOrder = true;
+                return order;
+            }
+        }
+    }
+    return order;
+}
+
+ExtractResult runExtraction(const DistDirectory &dist,
+                            const QVector<FileEntry> &entries,
+                            const QString &outDirPath,
+                            const ExtractOptions &options,
+                            const DistExtractor::ProgressCallback &progress,
+                            const DistExtractor::ByteProgressCallback &byteProgress,
+                            ExtractProgress *callerState) {
+    QElapsedTimer wall;
+    wall.start();
     ExtractResult result;
     result.total = entries.size();
 
-    if (!QDir().mkpath(outDirPath)) {
+    // Stopping at the first error has to follow input order, so payloads then
+    // run as soon as they are prepared, with readahead kept ahead of the
+    // input order instead of the offset plan. So do runs whose writes to a
+    // path could be reordered into a different result.
+    WriteOrder writeOrder;
+    if (options.continueOnError) {
+        writeOrder = planWriteOrder(entries);
+    }
+    const bool deferPayloads = options.continueOnError && !writeOrder.inputOrder;
+    const auto superseded = [&](int i) { return deferPayloads && writeOrder.superseded[size_t(i)]; };
+
+    ExtractProgress localState;
+    ExtractProgress *state = callerState ? callerState : &localState;
+    qint64 payloadBytes = 0;
+    for (int i = 0; i < entries.size(); ++i) {
+        const FileEntry &entry = entries.at(i);
+        if (entry.ftype == 'f' && entry.payloadSize > 0 && !superseded(i)) {
+            payloadBytes += entry.payloadSize;
+        }
+    }
+    state->begin(entries.size(), payloadBytes);
+
+    Metrics metrics;
+    ByteReporter reporter(byteProgress, state);
+    RunContext run;
+    run.state = state;
+    run.metrics = &metrics;
+    run.reporter = &reporter;
+
+    OutputTree output(outDirPath);
+    run.output = &output;
+    if (!output.isValid()) {
         result.errors = 1;
         result.errorMessages.push_back(QString("Cannot create output directory: %1").arg(outDirPath));
         return result;
     }
 
+    // Payloads are located up front, once per subproduct file; entries are
+    // then prepared in input order on this thread. Payload jobs
+    // are run afterwards sorted by subproduct and offset, so each file is
+    // read strictly forward with readahead hints kept ahead of the reads.
+    // With more than one worker, decoding and writing are handed to a
+    // bounded thread pool. Directory modes are applied once everything is
+    // written. Outcomes are collected per entry and tallied in input order
+    // afterwards so counts and error messages do not depend on scheduling.
+    const int workers = workerCount(options);
+    std::unique_ptr<QThreadPool> pool;
+    QSemaphore inFlight(workers * 4);
+    std::atomic<bool> failed(false);
+    if (workers > 1) {
+        pool = std::make_unique<QThreadPool>();
+        pool->setMaxThreadCount(workers);
+    }
+
+    std::vector<EntryOutcome> outcomes(size_t(entries.size()));
+
+    // The per-entry callback follows input order: it is called for each
+    // entry once it and every entry before it have finished, whatever order
+    // the payloads run in. Returning false cancels the run.
+    int reportedEntries = 0;
+    const auto reportFinished = [&]() {
+        while (reportedEntries < entries.size() &&
+               outcomes[size_t(reportedEntries)].finished.load(std::memory_order_acquire)) {
+            ++reportedEntries;
+            if (progress && !state->isCanceled() &&
+                !progress(reportedEntries, entries.size(), entries.at(reportedEntries - 1).fname)) {
+                state->cancel();
+            }
+        }
+        reporter.poll();
+    };
+
+    const auto runPayload = [&](PayloadJob job, EntryOutcome *outcome) {
+        if (!pool) {
+            const PayloadStatus status = writePayload(*job.source, job, options, run, &outcome->error);
+            recordPayload(status, state, outcome, &failed);
+            return;
+        }
+        while (!inFlight.tryAcquire(1, int(ByteReporter::kReportIntervalMs))) {
+            reportFinished();
+        }
+        pool->start(new PayloadTask(std::move(job), options, run, outcome, &inFlight, &failed));
+    };
+
+    std::vector<std::pair<int, PayloadJob>> planned;
+    ReadAheadWindow entryWindow(deferPayloads ? 0 : size_t(entries.size()));
+
     std::map<QString, std::unique_ptr<SubRuntime>> subStates;
+    mapPayloads(dist, entries, options, run, &subStates);
     for (int i = 0; i < entries.size(); ++i) {
         const FileEntry &entry = entries.at(i);
+        EntryOutcome &outcome = outcomes[size_t(i)];
 
-        if (progress && !progress(i + 1, entries.size(), entry.fname)) {
-            result.canceled = true;
+        if (!options.continueOnError && failed.load()) {
             break;
         }
 
-        if (entry.ftype != 'f' && entry.ftype != 'd' && entry.ftype != 'l') {
-            ++result.skipped;
+        state->setCurrentFile(entry.fname);
+        reportFinished();
+        if (state->isCanceled()) {
+            break;
+        }
+
+        if ((entry.ftype != 'f' && entry.ftype != 'd' && entry.ftype != 'l') || superseded(i)) {
+            outcome.state = EntryState::Skipped;
+            state->finishEntry();
+            outcome.finished.store(true, std::memory_order_release);
             continue;
         }
 
-        QString error;
-        const bool ok = extractOne(distDirPath, outDirPath, entry, options, &subStates, &error);
-        if (ok) {
+        PayloadJob job;
+        const EntryStep step = prepareOne(dist, entry, run, &subStates, &job, &outcome.error);
+        if (step != EntryStep::NeedsPayload) {
+            outcome.state = step == EntryStep::Done ? EntryState::Extracted : EntryState::Failed;
+            if (step == EntryStep::Failed) {
+                failed.store(true);
+            }
+            state->finishEntry();
+            outcome.finished.store(true, std::memory_order_release);
+            continue;
+        }
+
+        if (deferPayloads) {
+            planned.emplace_back(i, std::move(job));
+            continue;
+        }
+        entryWindow.moveTo(i, [&](int k) { return adviseEntry(entries.at(k), subStates); });
+        runPayload(std::move(job), &outcome);
+    }
+
+    if (!state->isCanceled()) {
+        std::stable_sort(planned.begin(), planned.end(), [](const auto &a, const auto &b) {
+            if (a.second.source != b.second.source) {
+                return a.second.entry->subproductBase < b.second.entry->subproductBase;
+            }
+            return a.second.dataOffset < b.second.dataOffset;
+        });
+
+        ReadAheadWindow planWindow(planned.size());
+        for (size_t k = 0; k < planned.size(); ++k) {
+            PayloadJob &job = planned[k].second;
+            planWindow.moveTo(int(k), [&planned](int next) {
+                const PayloadJob &ahead = planned[size_t(next)].second;
+                ahead.source->willNeed(ahead.dataOffset, ahead.entry->payloadSize);
+                return ahead.entry->payloadSize;
+            });
+
+            state->setCurrentFile(job.entry->fname);
+            reportFinished();
+            if (state->isCanceled()) {
+                break;
+            }
+            runPayload(std::move(job), &outcomes[size_t(planned[k].first)]);
+        }
+    }
+
+    if (pool) {
+        while (!pool->waitForDone(int(ByteReporter::kReportIntervalMs))) {
+            reportFinished();
+        }
+    }
+    reportFinished();
+    {
+        PhaseTimer timer(metrics.chmodNs);
+        output.applyMetadata();
+    }
+    reporter.poll(true);
+    if (state->isCanceled()) {
+        result.canceled = true;
+    }
+
+    // With continueOnError off, report exactly what a sequential run would:
+    // everything up to and including the first failure in input order.
+    for (int i = 0; i < entries.size(); ++i) {
+        const EntryOutcome &outcome = outcomes[size_t(i)];
+        if (outcome.state == EntryState::NotRun) {
+            continue;
+        }
+        if (outcome.state == EntryState::Skipped) {
+            ++result.skipped;
+            continue;
+        }
+        if (outcome.state == EntryState::Extracted) {
             ++result.extracted;
             continue;
         }
 
         ++result.errors;
-        result.errorMessages.push_back(QString("%1: %2").arg(entry.fname, error));
+        result.errorMessages.push_back(QString("%1: %2").arg(entries.at(i).fname, outcome.error));
         if (!options.continueOnError) {
             break;
         }
     }
 
+    result.bytesRead = state->bytesDone();
+    result.bytesWritten = metrics.bytesWritten.load();
+    result.timings.locateNs = metrics.locateNs.load();
+    result.timings.readNs = metrics.readNs.load();
+    result.timings.decodeNs = metrics.decodeNs.load();
+    result.timings.writeNs = metrics.writeNs.load();
+    result.timings.chmodNs = metrics.chmodNs.load();
+    result.elapsedNs = wall.nsecsElapsed();
     return result;
 }
 
+} // namespace
+
+QString ExtractProgress::currentFile() const {
+    QMutexLocker locker(&m_fileMutex);
+    return m_currentFile;
+}
+
+void ExtractProgress::begin(int entriesTotal, qint64 bytesTotal) {
+    m_entriesDone.store(0);
+    m_bytesDone.store(0);
+    m_entriesTotal.store(entriesTotal);
+    m_bytesTotal.store(bytesTotal);
+    setCurrentFile(QString());
+}
+
+void ExtractProgress::setCurrentFile(const QString &name) {
+    QMutexLocker locker(&m_fileMutex);
+    m_currentFile = name;
+}
+
+ExtractResult DistExtractor::extract(const QString &distDirPath,
+                                     const QVector<FileEntry> &entries,
+                                     const QString &outDirPath,
+                                     const ExtractOptions &options,
+                                     const ProgressCallback &progress,
+                                     ExtractProgress *state) {
+    return extract(DistDirectory(distDirPath), entries, outDirPath, options, progress, state);
+}
+
+ExtractResult DistExtractor::extract(const DistDirectory &dist,
+                                     const QVector<FileEntry> &entries,
+                                     const QString &outDirPath,
+                                     const ExtractOptions &options,
+                                     const ProgressCallback &progress,
+                                     ExtractProgress *state) {
+    return runExtraction(dist, entries, outDirPath, options, progress, {}, state);
+}
+
+ExtractResult DistExtractor::extract(const DistDirectory &dist,
+                                     const QVector<FileEntry> &entries,
+                                     const QString &outDirPath,
+                                     const ExtractOptions &options,
+                                     const ByteProgressCallback &progress,
+                                     ExtractProgress *state) {
+    return runExtraction(dist, entries, outDirPath, options, {}, progress, state);
+}
+
 } // namespace swcore
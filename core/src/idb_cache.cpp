@@ -0,0 +1,331 @@
+#include "swcore/idb_cache.h"
+
+#include "swcore/dist_directory.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace swcore {
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'W', 'I', 'D', 'X', 0, 0, 0};
+constexpr quint32 kFormatVersion = 2;
+constexpr quint32 kByteOrderMark = 0x01020304;
+// Indexes kept in a cache directory; older ones are removed on store().
+constexpr int kMaxCachedIndexes = 64;
+
+// On-disk layout, written in host byte order; an index from a host with a
+// different byte order is rejected by the byte order mark and re-parsed.
+struct IndexHeader {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    qint64 idbSize;
+    qint64 idbMtimeMs;
+    char hash[16];
+    char distHash[16];
+    quint32 stringCount;
+    quint32 entryCount;
+    quint32 warningCount;
+    quint32 productId;
+    quint64 stringsOffset;
+    quint64 blobOffset;
+    quint64 blobSize;
+    quint64 entriesOffset;
+    quint64 warningsOffset;
+};
+
+struct StringRef {
+    quint32 offset;
+    quint32 length;
+};
+
+struct EntryRecord {
+    quint16 ftype;
+    quint16 reserved0;
+    qint32 mode;
+    quint32 user;
+    quint32 group;
+    quint32 fname;
+    quint32 sourcePath;
+    quint32 subgroup;
+    quint32 subproductBase;
+    quint32 attrsRaw;
+    quint32 machExpr;
+    quint32 symval;
+    quint32 reserved1;
+    qint64 size;
+    qint64 cmpsize;
+    qint64 payloadSize;
+    qint64 offset;
+};
+
+static_assert(std::is_trivially_copyable<IndexHeader>::value, "IndexHeader must be POD");
+static_assert(sizeof(EntryRecord) == 80, "EntryRecord layout changed");
+
+class StringTable {
+public:
+    quint32 intern(const QString &s) {
+        const auto it = m_ids.constFind(s);
+        if (it != m_ids.constEnd()) {
+            return it.value();
+        }
+        const quint32 id = quint32(m_refs.size());
+        const QByteArray latin1 = s.toLatin1();
+        m_refs.push_back({quint32(m_blob.size()), quint32(latin1.size())});
+        m_blob.append(latin1);
+        m_ids.insert(s, id);
+        return id;
+    }
+
+    const std::vector<StringRef> &refs() const { return m_refs; }
+    const QByteArray &blob() const { return m_blob; }
+
+private:
+    QHash<QString, quint32> m_ids;
+    std::vector<StringRef> m_refs;
+    QByteArray m_blob;
+};
+
+void appendAligned(QByteArray *out, const void *data, qint64 size, quint64 *offset) {
+    while (out->size() % 8 != 0) {
+        out->append('\0');
+    }
+    *offset = quint64(out->size());
+    out->append(static_cast<const char *>(data), int(size));
+}
+
+QString indexPath(const QString &cacheDir, const QString &idbPath) {
+    const QByteArray id =
+        QCryptographicHash::hash(QFileInfo(idbPath).absoluteFilePath().toUtf8(), QCryptographicHash::Md5).toHex();
+    return QDir(cacheDir).filePath(QString::fromLatin1(id) + ".swidx");
+}
+
+bool inRange(quint64 offset, quint64 size, quint64 total) {
+    return offset <= total && size <= total - offset;
+}
+
+void pruneIndexes(const QString &cacheDir) {
+    const QFileInfoList indexes = QDir(cacheDir).entryInfoList({"*.swidx"}, QDir::Files, QDir::Time);
+    for (int i = kMaxCachedIndexes; i < indexes.size(); ++i) {
+        QFile::remove(indexes.at(i).filePath());
+    }
+}
+
+} // namespace
+
+QString IdbCache::defaultDirectory() {
+    QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (base.isEmpty()) {
+        base = QDir(QDir::tempPath()).filePath("sw-explorer");
+    }
+    return QDir(base).filePath("idb-index");
+}
+
+IdbCacheKey IdbCache::keyFor(const DistDirectory &dist, const QString &product) {
+    const QString idbPath = dist.filePath(product + ".idb");
+    IdbCacheKey key;
+    key.idbPath = QFileInfo(idbPath).absoluteFilePath();
+
+    QFile file(idbPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return key;
+    }
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    if (!hash.addData(&file)) {
+        return key;
+    }
+    const QFileInfo fi(idbPath);
+    key.size = fi.size();
+    key.mtimeMs = fi.lastModified().toMSecsSinceEpoch();
+    key.hash = hash.result();
+    key.distHash = dist.subproductFingerprint();
+    return key;
+}
+
+bool IdbCache::load(const QString &cacheDir, const IdbCacheKey &key, ParseResult *result) {
+    if (!result || !key.isValid() || key.hash.size() != 16 || key.distHash.size() != 16) {
+        return false;
+    }
+
+    QFile file(indexPath(cacheDir, key.idbPath));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const quint64 total = quint64(file.size());
+    if (total < sizeof(IndexHeader)) {
+        return false;
+    }
+    const uchar *map = file.map(0, qint64(total));
+    if (!map) {
+        return false;
+    }
+    const char *base = reinterpret_cast<const char *>(map);
+
+    IndexHeader hdr;
+    std::memcpy(&hdr, base, sizeof(hdr));
+    if (std::memcmp(hdr.magic, kMagic, sizeof(kMagic)) != 0 || hdr.version != kFormatVersion ||
+        hdr.byteOrder != kByteOrderMark) {
+        return false;
+    }
+    if (hdr.idbSize != key.size || hdr.idbMtimeMs != key.mtimeMs ||
+        std::memcmp(hdr.hash, key.hash.constData(), sizeof(hdr.hash)) != 0 ||
+        std::memcmp(hdr.distHash, key.distHash.constData(), sizeof(hdr.distHash)) != 0) {
+        return false;
+    }
+    if (!inRange(hdr.stringsOffset, quint64(hdr.stringCount) * sizeof(StringRef), total) ||
+        !inRange(hdr.blobOffset, hdr.blobSize, total) ||
+        !inRange(hdr.entriesOffset, quint64(hdr.entryCount) * sizeof(EntryRecord), total) ||
+        !inRange(hdr.warningsOffset, quint64(hdr.warningCount) * sizeof(quint32), total) ||
+        hdr.productId >= hdr.stringCount) {
+        return false;
+    }
+
+    // One QString per distinct value; entries share them through implicit sharing.
+    ParseResult parsed;
+    std::vector<QString> strings(hdr.stringCount);
+    const char *blob = base + hdr.blobOffset;
+    for (quint32 i = 0; i < hdr.stringCount; ++i) {
+        StringRef ref;
+        std::memcpy(&ref, base + hdr.stringsOffset + i * sizeof(StringRef), sizeof(ref));
+        if (!inRange(ref.offset, ref.length, hdr.blobSize)) {
+            return false;
+        }
+        strings[i] = QString::fromLatin1(blob + ref.offset, int(ref.length));
+    }
+
+    auto str = [&](quint32 id, bool *ok) -> const QString & {
+        static const QString empty;
+        if (id >= strings.size()) {
+            *ok = false;
+            return empty;
+        }
+        return strings[id];
+    };
+    // Fields that parse() interns are registered with the result's pool too.
+    std::vector<bool> pooled(hdr.stringCount, false);
+    auto pooledStr = [&](quint32 id, bool *ok) -> const QString & {
+        const QString &s = str(id, ok);
+        if (*ok && !pooled[id]) {
+            strings[id] = parsed.strings.intern(s);
+            pooled[id] = true;
+        }
+        return *ok ? strings[id] : s;
+    };
+
+    bool ok = true;
+    parsed.product = str(hdr.productId, &ok);
+    parsed.entries.reserve(int(hdr.entryCount));
+    for (quint32 i = 0; i < hdr.entryCount && ok; ++i) {
+        EntryRecord rec;
+        std::memcpy(&rec, base + hdr.entriesOffset + i * sizeof(EntryRecord), sizeof(rec));
+        FileEntry e;
+        e.ftype = QChar(rec.ftype);
+        e.mode = rec.mode;
+        e.user = pooledStr(rec.user, &ok);
+        e.group = pooledStr(rec.group, &ok);
+        e.fname = str(rec.fname, &ok);
+        e.sourcePath = str(rec.sourcePath, &ok);
+        e.subgroup = pooledStr(rec.subgroup, &ok);
+        e.subproductBase = pooledStr(rec.subproductBase, &ok);
+        e.attrsRaw = str(rec.attrsRaw, &ok);
+        e.machExpr = pooledStr(rec.machExpr, &ok);
+        e.symval = str(rec.symval, &ok);
+        e.size = rec.size;
+        e.cmpsize = rec.cmpsize;
+        e.payloadSize = rec.payloadSize;
+        e.offset = rec.offset;
+        parsed.entries.push_back(std::move(e));
+    }
+    for (quint32 i = 0; i < hdr.warningCount && ok; ++i) {
+        quint32 id = 0;
+        std::memcpy(&id, base + hdr.warningsOffset + i * sizeof(quint32), sizeof(id));
+        parsed.warnings.push_back(str(id, &ok));
+    }
+    if (!ok) {
+        return false;
+    }
+
+    *result = std::move(parsed);
+    return true;
+}
+
+bool IdbCache::store(const QString &cacheDir, const IdbCacheKey &key, const ParseResult &result) {
+    if (!key.isValid() || key.hash.size() != 16 || key.distHash.size() != 16 || !QDir().mkpath(cacheDir)) {
+        return false;
+    }
+
+    StringTable strings;
+    std::vector<EntryRecord> records;
+    records.reserve(size_t(result.entries.size()));
+    for (const FileEntry &e : result.entries) {
+        EntryRecord rec;
+        std::memset(&rec, 0, sizeof(rec));
+        rec.ftype = e.ftype.unicode();
+        rec.mode = e.mode;
+        rec.user = strings.intern(e.user);
+        rec.group = strings.intern(e.group);
+        rec.fname = strings.intern(e.fname);
+        rec.sourcePath = strings.intern(e.sourcePath);
+        rec.subgroup = strings.intern(e.subgroup);
+        rec.subproductBase = strings.intern(e.subproductBase);
+        rec.attrsRaw = strings.intern(e.attrsRaw);
+        rec.machExpr = strings.intern(e.machExpr);
+        rec.symval = strings.intern(e.symval);
+        rec.size = e.size;
+        rec.cmpsize = e.cmpsize;
+        rec.payloadSize = e.payloadSize;
+        rec.offset = e.offset;
+        records.push_back(rec);
+    }
+    std::vector<quint32> warnings;
+    warnings.reserve(size_t(result.warnings.size()));
+    for (const QString &w : result.warnings) {
+        warnings.push_back(strings.intern(w));
+    }
+
+    IndexHeader hdr;
+    std::memset(&hdr, 0, sizeof(hdr));
+    std::memcpy(hdr.magic, kMagic, sizeof(kMagic));
+    hdr.version = kFormatVersion;
+    hdr.byteOrder = kByteOrderMark;
+    hdr.idbSize = key.size;
+    hdr.idbMtimeMs = key.mtimeMs;
+    std::memcpy(hdr.hash, key.hash.constData(), sizeof(hdr.hash));
+    std::memcpy(hdr.distHash, key.distHash.constData(), sizeof(hdr.distHash));
+    hdr.productId = strings.intern(result.product);
+    hdr.stringCount = quint32(strings.refs().size());
+    hdr.entryCount = quint32(records.size());
+    hdr.warningCount = quint32(warnings.size());
+
+    QByteArray out(int(sizeof(hdr)), '\0');
+    appendAligned(&out, strings.refs().data(), qint64(strings.refs().size() * sizeof(StringRef)), &hdr.stringsOffset);
+    appendAligned(&out, strings.blob().constData(), strings.blob().size(), &hdr.blobOffset);
+    hdr.blobSize = quint64(strings.blob().size());
+    appendAligned(&out, records.data(), qint64(records.size() * sizeof(EntryRecord)), &hdr.entriesOffset);
+    appendAligned(&out, warnings.data(), qint64(warnings.size() * sizeof(quint32)), &hdr.warningsOffset);
+    std::memcpy(out.data(), &hdr, sizeof(hdr));
+
+    QSaveFile file(indexPath(cacheDir, key.idbPath));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    if (file.write(out) != out.size() || !file.commit()) {
+        return false;
+    }
+    pruneIndexes(cacheDir);
+    return true;
+}
+
+} // namespace swcore
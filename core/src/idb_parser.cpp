@@ -1,15 +1,15 @@
 #include "swcore/idb_parser.h"
 
-#include <QDir>
+#include "swcore/dist_directory.h"
+#include "swcore/idb_cache.h"
+
 #include <QFile>
 #include <QFileInfo>
 #include <QMap>
-#include <QRegularExpression>
-#include <QTextStream>
-#include <QtGlobal>
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-#include <QStringConverter>
-#endif
+
+#include <climits>
+#include <cstring>
+#include <vector>
 
 namespace swcore {
 
@@ -17,91 +17,199 @@ namespace {
 
 constexpr qint64 kIdbHeaderLength = 13;
 
+// A slice of the raw Latin-1 idb buffer. QStrings are only built for the
+// fields that end up in a FileEntry.
+struct Token {
+    const char *data = nullptr;
+    int size = 0;
+
+    bool isEmpty() const { return size == 0; }
+    QString toString() const { return QString::fromLatin1(data, size); }
+    bool contains(char c) const { return size > 0 && std::memchr(data, c, size_t(size)) != nullptr; }
+};
+
 struct AttrInfo {
     qint64 size = 0;
     qint64 cmpsize = 0;
-    QString symval;
-    QString machExpr;
+    Token symval;
+    Token machExpr;
 };
 
-QString subproductBase(const QString &subgroup) {
-    const QStringList parts = subgroup.split('.', Qt::SkipEmptyParts);
-    if (parts.size() < 2) {
-        return {};
+// What the "\\s+" field split matched: ASCII whitespace only.
+inline bool isFieldSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// QChar::isSpace() for Latin-1, as QString::trimmed() used it.
+inline bool isSpace(char c) {
+    const uchar u = uchar(c);
+    return isFieldSpace(c) || u == 0x85 || u == 0xa0;
+}
+
+Token trimmed(Token t) {
+    while (t.size > 0 && isSpace(t.data[0])) {
+        ++t.data;
+        --t.size;
+    }
+    while (t.size > 0 && isSpace(t.data[t.size - 1])) {
+        --t.size;
+    }
+    return t;
+}
+
+bool equalsLower(Token t, const char *lowerWord) {
+    const int n = int(std::strlen(lowerWord));
+    if (t.size != n) {
+        return false;
+    }
+    for (int i = 0; i < n; ++i) {
+        char c = t.data[i];
+        if (c >= 'A' && c <= 'Z') {
+            c = char(c - 'A' + 'a');
+        }
+        if (c != lowerWord[i]) {
+            return false;
+        }
     }
-    return parts.at(0) + "." + parts.at(1);
+    return true;
 }
 
-QStringList splitMax(const QString &line, int maxParts) {
-    QStringList out;
-    out.reserve(maxParts);
-    const int n = line.size();
+// Same acceptance as QString::toLongLong()/toInt(): optional sign, digits of
+// the given base only, 0 on failure or overflow.
+qint64 parseInteger(Token t, int base, bool *ok) {
+    *ok = false;
     int i = 0;
+    bool negative = false;
+    if (i < t.size && (t.data[i] == '+' || t.data[i] == '-')) {
+        negative = t.data[i] == '-';
+        ++i;
+    }
+    if (i >= t.size) {
+        return 0;
+    }
+    quint64 value = 0;
+    for (; i < t.size; ++i) {
+        const int digit = t.data[i] - '0';
+        if (digit < 0 || digit >= base) {
+            return 0;
+        }
+        value = value * quint64(base) + quint64(digit);
+        if (value > quint64(INT64_MAX)) {
+            return 0;
+        }
+    }
+    *ok = true;
+    return negative ? -qint64(value) : qint64(value);
+}
 
-    while (i < n && out.size() < maxParts - 1) {
-        while (i < n && line.at(i).isSpace()) {
+// Splits on whitespace into views of the line; tokens keeps its capacity
+// across lines so steady-state parsing does not allocate.
+void tokenize(const char *line, int size, std::vector<Token> *tokens) {
+    tokens->clear();
+    int i = 0;
+    while (i < size) {
+        while (i < size && isFieldSpace(line[i])) {
             ++i;
         }
-        if (i >= n) {
+        if (i >= size) {
             break;
         }
         const int start = i;
-        while (i < n && !line.at(i).isSpace()) {
+        while (i < size && !isFieldSpace(line[i])) {
             ++i;
         }
-        out.push_back(line.mid(start, i - start));
+        tokens->push_back({line + start, i - start});
     }
+}
 
-    while (i < n && line.at(i).isSpace()) {
-        ++i;
+// The subproduct file name is the first two non-empty dot-separated parts of
+// a subgroup. Returns a view into the subgroup when the parts are adjacent,
+// otherwise into scratch; empty when there are fewer than two parts.
+Token subproductBase(Token subgroup, QByteArray *scratch) {
+    Token parts[2];
+    int found = 0;
+    int i = 0;
+    while (i < subgroup.size && found < 2) {
+        while (i < subgroup.size && subgroup.data[i] == '.') {
+            ++i;
+        }
+        const int start = i;
+        while (i < subgroup.size && subgroup.data[i] != '.') {
+            ++i;
+        }
+        if (i > start) {
+            parts[found++] = {subgroup.data + start, i - start};
+        }
     }
-    if (i < n && out.size() < maxParts) {
-        out.push_back(line.mid(i));
+    if (found < 2) {
+        return {};
+    }
+    if (parts[1].data == parts[0].data + parts[0].size + 1) {
+        return {parts[0].data, parts[0].size + 1 + parts[1].size};
     }
-    return out;
+    scratch->clear();
+    scratch->append(parts[0].data, parts[0].size);
+    scratch->append('.');
+    scratch->append(parts[1].data, parts[1].size);
+    return {scratch->constData(), int(scratch->size())};
 }
 
-bool looksLikeSubgroupToken(const QString &token) {
-    if (token.contains('(') || token.contains(')') || token.contains('/') || token.contains('=')) {
-        return false;
+bool isSubgroupChar(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_' || c == '+' ||
+           c == '.' || c == '-';
+}
+
+// Byte-level equivalent of
+// ^[A-Za-z0-9_+.-]+\.[A-Za-z0-9_+.-]+\.[A-Za-z0-9_+.-]+(?:\.[A-Za-z0-9_+.-]+)*$
+bool looksLikeSubgroupToken(Token token) {
+    int firstDot = -1;
+    int lastDot = -1;
+    for (int i = 0; i < token.size; ++i) {
+        const char c = token.data[i];
+        if (!isSubgroupChar(c)) {
+            return false;
+        }
+        if (c == '.') {
+            if (firstDot < 0 && i >= 1) {
+                firstDot = i;
+            }
+            if (i <= token.size - 2) {
+                lastDot = i;
+            }
+        }
     }
-    static const QRegularExpression re(
-        "^[A-Za-z0-9_+.-]+\\.[A-Za-z0-9_+.-]+\\.[A-Za-z0-9_+.-]+(?:\\.[A-Za-z0-9_+.-]+)*$");
-    return re.match(token).hasMatch();
+    return firstDot >= 0 && lastDot >= 0 && lastDot - firstDot >= 2;
 }
 
-int findSubgroupTokenIndex(const QStringList &tailTokens, const QString &distDirPath) {
+int findSubgroupTokenIndex(const std::vector<Token> &tailTokens, const DistDirectory &dist, QByteArray *scratch) {
+    const int count = int(tailTokens.size());
     // Prefer a token whose subproduct base exists as a file in dist dir.
-    for (int i = 0; i < tailTokens.size(); ++i) {
-        const QString tok = tailTokens.at(i);
-        const QString base = subproductBase(tok);
-        if (base.isEmpty()) {
-            continue;
-        }
-        const QString subPath = QDir(distDirPath).filePath(base);
-        if (QFileInfo::exists(subPath)) {
+    for (int i = 0; i < count; ++i) {
+        const Token base = subproductBase(tailTokens[i], scratch);
+        if (!base.isEmpty() && dist.contains(base.data, base.size)) {
             return i;
         }
     }
 
     // Fallback for unusual dist layouts.
-    for (int i = 0; i < tailTokens.size(); ++i) {
-        if (looksLikeSubgroupToken(tailTokens.at(i))) {
+    for (int i = 0; i < count; ++i) {
+        if (looksLikeSubgroupToken(tailTokens[i])) {
             return i;
         }
     }
     return -1;
 }
 
-void parseAttrs(const QString &attrs, AttrInfo *info) {
+void parseAttrs(Token attrs, AttrInfo *info) {
     if (!info) {
         return;
     }
 
+    const char *s = attrs.data;
+    const int n = attrs.size;
     int i = 0;
-    const int n = attrs.size();
     while (i < n) {
-        while (i < n && attrs.at(i).isSpace()) {
+        while (i < n && isFieldSpace(s[i])) {
             ++i;
         }
         if (i >= n) {
@@ -109,47 +217,48 @@ void parseAttrs(const QString &attrs, AttrInfo *info) {
         }
 
         const int keyStart = i;
-        while (i < n && !attrs.at(i).isSpace() && attrs.at(i) != '(') {
+        while (i < n && !isFieldSpace(s[i]) && s[i] != '(') {
             ++i;
         }
-        const QString key = attrs.mid(keyStart, i - keyStart).trimmed();
+        const Token key = trimmed({s + keyStart, i - keyStart});
         if (key.isEmpty()) {
             ++i;
             continue;
         }
 
-        if (i >= n || attrs.at(i) != '(') {
+        if (i >= n || s[i] != '(') {
             continue;
         }
 
         ++i;
         const int valStart = i;
-        QString value;
+        Token value;
         while (true) {
-            const int close = attrs.indexOf(')', i);
-            if (close < 0) {
-                value = attrs.mid(valStart).trimmed();
+            const void *hit = i < n ? std::memchr(s + i, ')', size_t(n - i)) : nullptr;
+            if (!hit) {
+                value = trimmed({s + valStart, n - valStart});
                 i = n;
                 break;
             }
-            if (close > 0 && attrs.at(close - 1) == ':') {
+            const int close = int(static_cast<const char *>(hit) - s);
+            if (close > 0 && s[close - 1] == ':') {
                 i = close + 1;
                 continue;
             }
-            value = attrs.mid(valStart, close - valStart);
+            value = {s + valStart, close - valStart};
             i = close + 1;
             break;
         }
 
-        const QString lower = key.toLower();
-        if (lower == "cmpsize") {
-            info->cmpsize = value.trimmed().toLongLong();
-        } else if (lower == "size") {
-            info->size = value.trimmed().toLongLong();
-        } else if (lower == "symval") {
+        bool ok = false;
+        if (equalsLower(key, "cmpsize")) {
+            info->cmpsize = parseInteger(trimmed(value), 10, &ok);
+        } else if (equalsLower(key, "size")) {
+            info->size = parseInteger(trimmed(value), 10, &ok);
+        } else if (equalsLower(key, "symval")) {
             info->symval = value;
-        } else if (lower == "mach") {
-            info->machExpr = value.trimmed();
+        } else if (equalsLower(key, "mach")) {
+            info->machExpr = trimmed(value);
         }
     }
 }
@@ -157,16 +266,18 @@ void parseAttrs(const QString &attrs, AttrInfo *info) {
 } // namespace
 
 QStringList IdbParser::findProducts(const QString &distDirPath) {
-    QDir dir(distDirPath);
-    QStringList products;
-    const QFileInfoList files = dir.entryInfoList({"*.idb"}, QDir::Files, QDir::Name);
-    for (const QFileInfo &fi : files) {
-        products.push_back(fi.completeBaseName());
-    }
-    return products;
+    return findProducts(DistDirectory(distDirPath));
+}
+
+QStringList IdbParser::findProducts(const DistDirectory &dist) {
+    return dist.products();
 }
 
 ParseResult IdbParser::parse(const QString &distDirPath, const QString &product, QString *errorMessage) {
+    return parse(DistDirectory(distDirPath), product, errorMessage);
+}
+
+ParseResult IdbParser::parse(const DistDirectory &dist, const QString &product, QString *errorMessage) {
     ParseResult result;
     result.product = product;
 
@@ -176,66 +287,68 @@ ParseResult IdbParser::parse(const QString &distDirPath, const QString &product,
         }
     };
 
-    const QString idbPath = QDir(distDirPath).filePath(product + ".idb");
+    const QString idbPath = dist.filePath(product + ".idb");
     QFile idbFile(idbPath);
     if (!idbFile.open(QIODevice::ReadOnly)) {
         setError(QString("Cannot open idb: %1").arg(idbPath));
         return {};
     }
 
-    QTextStream ts(&idbFile);
-#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
-    ts.setEncoding(QStringConverter::Latin1);
-#else
-    ts.setCodec("ISO-8859-1");
-#endif
+    // The idb is Latin-1; work on the raw bytes so offsets stay byte exact.
+    const QByteArray bytes = idbFile.readAll();
+    const char *data = bytes.constData();
+    const int size = bytes.size();
 
+    std::vector<Token> tokens;
+    std::vector<Token> tail;
+    QByteArray attrsBuf;
+    QByteArray baseBuf;
     QMap<QString, qint64> curoffBySub;
     int lineNo = 0;
-    while (!ts.atEnd()) {
-        const QString line = ts.readLine();
+    int pos = 0;
+
+    while (pos < size) {
+        const char *nl = static_cast<const char *>(std::memchr(data + pos, '\n', size_t(size - pos)));
+        const int lineEnd = nl ? int(nl - data) : size;
+        const char *line = data + pos;
+        const int lineLen = lineEnd - pos;
+        pos = lineEnd + 1;
         ++lineNo;
-        if (line.trimmed().isEmpty()) {
+
+        tokenize(line, lineLen, &tokens);
+        if (tokens.empty() || trimmed({line, lineLen}).isEmpty()) {
             continue;
         }
-
-        const QStringList tokens = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
         if (tokens.size() < 7) {
             result.warnings.push_back(QString("Line %1 ignored: not enough fields").arg(lineNo));
             continue;
         }
 
         FileEntry entry;
-        entry.ftype = tokens.at(0).isEmpty() ? QChar() : tokens.at(0).at(0);
+        entry.ftype = QChar::fromLatin1(tokens[0].data[0]);
         bool modeOk = false;
-        entry.mode = tokens.at(1).toInt(&modeOk, 8);
-        if (!modeOk) {
-            entry.mode = 0;
-        }
-        entry.user = tokens.at(2);
-        entry.group = tokens.at(3);
-        entry.fname = tokens.at(4);
-        entry.sourcePath = tokens.at(5);
+        const qint64 mode = parseInteger(tokens[1], 8, &modeOk);
+        entry.mode = modeOk && mode >= INT_MIN && mode <= INT_MAX ? int(mode) : 0;
 
-        QStringList tailTokens = tokens.mid(6);
-        const int subgroupIdx = findSubgroupTokenIndex(tailTokens, distDirPath);
+        tail.assign(tokens.begin() + 6, tokens.end());
+        const int subgroupIdx = findSubgroupTokenIndex(tail, dist, &baseBuf);
         if (subgroupIdx < 0) {
             result.warnings.push_back(QString("Line %1 ignored: cannot locate subgroup token").arg(lineNo));
             continue;
         }
-        entry.subgroup = tailTokens.at(subgroupIdx);
-        tailTokens.removeAt(subgroupIdx);
-        entry.attrsRaw = tailTokens.join(' ');
-        entry.subproductBase = subproductBase(entry.subgroup);
+        const Token subgroup = tail[size_t(subgroupIdx)];
+        tail.erase(tail.begin() + subgroupIdx);
 
+        const Token base = subproductBase(subgroup, &baseBuf);
+        entry.subproductBase = result.strings.intern(base.data, base.size);
+        entry.subgroup = result.strings.intern(subgroup.data, subgroup.size);
         if (entry.subproductBase.isEmpty()) {
             result.warnings.push_back(QString("Line %1 ignored: bad subgroup '%2'").arg(lineNo).arg(entry.subgroup));
             continue;
         }
 
         if (!curoffBySub.contains(entry.subproductBase)) {
-            const QString subPath = QDir(distDirPath).filePath(entry.subproductBase);
-            if (!QFileInfo::exists(subPath)) {
+            if (!dist.contains(entry.subproductBase)) {
                 setError(QString("Missing subproduct file '%1' referenced by %2:%3")
                              .arg(entry.subproductBase, QFileInfo(idbPath).fileName())
                              .arg(lineNo));
@@ -244,13 +357,27 @@ ParseResult IdbParser::parse(const QString &distDirPath, const QString &product,
             curoffBySub.insert(entry.subproductBase, kIdbHeaderLength);
         }
 
-        if (!entry.attrsRaw.isEmpty()) {
+        entry.user = result.strings.intern(tokens[2].data, tokens[2].size);
+        entry.group = result.strings.intern(tokens[3].data, tokens[3].size);
+        entry.fname = tokens[4].toString();
+        entry.sourcePath = tokens[5].toString();
+
+        if (!tail.empty()) {
+            attrsBuf.clear();
+            for (size_t i = 0; i < tail.size(); ++i) {
+                if (i > 0) {
+                    attrsBuf.append(' ');
+                }
+                attrsBuf.append(tail[i].data, tail[i].size);
+            }
+            entry.attrsRaw = QString::fromLatin1(attrsBuf);
+
             AttrInfo info;
-            parseAttrs(entry.attrsRaw, &info);
+            parseAttrs({attrsBuf.constData(), int(attrsBuf.size())}, &info);
             entry.size = info.size;
             entry.cmpsize = info.cmpsize;
-            entry.symval = info.symval;
-            entry.machExpr = info.machExpr;
+            entry.symval = info.symval.toString();
+            entry.machExpr = result.strings.intern(info.machExpr.data, info.machExpr.size);
         }
 
         if (entry.ftype == 'f') {
@@ -258,7 +385,7 @@ ParseResult IdbParser::parse(const QString &distDirPath, const QString &product,
             entry.payloadSize = payload;
             entry.offset = curoffBySub.value(entry.subproductBase);
 
-            const qint64 nameLen = entry.fname.toLatin1().size();
+            const qint64 nameLen = tokens[4].size;
             curoffBySub[entry.subproductBase] = entry.offset + payload + nameLen + 2;
         }
 
@@ -271,4 +398,37 @@ ParseResult IdbParser::parse(const QString &distDirPath, const QString &product,
     return result;
 }
 
+ParseResult IdbParser::parseCached(const QString &distDirPath,
+                                   const QString &product,
+                                   const QString &cacheDir,
+                                   QString *errorMessage) {
+    return parseCached(DistDirectory(distDirPath), product, cacheDir, errorMessage);
+}
+
+ParseResult IdbParser::parseCached(const DistDirectory &dist,
+                                   const QString &product,
+                                   const QString &cacheDir,
+                                   QString *errorMessage) {
+    const QString dir = cacheDir.isEmpty() ? IdbCache::defaultDirectory() : cacheDir;
+    const IdbCacheKey key = IdbCache::keyFor(dist, product);
+
+    ParseResult result;
+    if (key.isValid() && IdbCache::load(dir, key, &result)) {
+        if (errorMessage) {
+            errorMessage->clear();
+        }
+        return result;
+    }
+
+    QString error;
+    result = parse(dist, product, &error);
+    if (errorMessage) {
+        *errorMessage = error;
+    }
+    if (error.isEmpty() && key.isValid()) {
+        IdbCache::store(dir, key, result);
+    }
+    return result;
+}
+
 } // namespace swcore
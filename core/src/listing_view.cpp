@@ -0,0 +1,142 @@
+#include "swcore/listing_view.h"
+
+#include "swcore/wildcard.h"
+
+namespace swcore {
+
+std::shared_ptr<const SubgroupView> SubgroupView::build(const std::shared_ptr<const EntryStore> &store,
+                                                        const QString &mask) {
+    auto view = std::make_shared<SubgroupView>();
+    view->store = store;
+    view->mask = mask;
+    view->indexes.reserve(store->count());
+
+    const WildcardMask matcher(mask);
+    if (matcher.matchesAll()) {
+        for (int i = 0; i < store->count(); ++i) {
+            view->indexes.push_back(i);
+        }
+    } else {
+        // The mask is evaluated once per distinct subgroup; entries only
+        // look up their subgroup's result.
+        const QStringList &subgroups = store->subgroups();
+        std::vector<char> selected(size_t(subgroups.size()), 0);
+        for (int id = 0; id < subgroups.size(); ++id) {
+            selected[size_t(id)] = matcher.matches(subgroups.at(id)) ? 1 : 0;
+        }
+        for (int i = 0; i < store->count(); ++i) {
+            if (selected[size_t(store->subgroupId(i))]) {
+                view->indexes.push_back(i);
+            }
+        }
+    }
+    view->tree = DirectoryTree(*store, view->indexes);
+    return view;
+}
+
+bool NameView::isPathQuery(const QString &filter) {
+    return filter.contains('/') || PathQuery(filter).isGlob();
+}
+
+std::shared_ptr<const NameView> NameView::build(const std::shared_ptr<const SubgroupView> &subgroups,
+                                                const QString &filter,
+                                                const PathIndex *index,
+                                                const NameView *base,
+                                                const std::atomic<quint64> *latest,
+                                                quint64 generation) {
+    const EntryStore &store = *subgroups->store;
+    const DirectoryTree &tree = subgroups->tree;
+
+    auto view = std::make_shared<NameView>();
+    view->subgroups = subgroups;
+    view->filter = filter;
+    view->filterLower = filter.toLower();
+    const bool pathMode = isPathQuery(filter);
+    if (pathMode) {
+        view->pathQuery = PathQuery(filter);
+    }
+    view->matchDirs.assign(size_t(tree.nodeCount()), 0);
+    if (view->filterLower.isEmpty()) {
+        return view;
+    }
+
+    // A plain filter that extends the previous one of the same kind can only
+    // narrow its matches.
+    const bool refine = base && base->subgroups == subgroups && !base->filterLower.isEmpty() &&
+                        view->filterLower.contains(base->filterLower) && pathMode == !base->pathQuery.isEmpty() &&
+                        !base->pathQuery.isGlob() && !view->pathQuery.isGlob();
+
+    QVector<int> &matches = view->matches;
+    if (pathMode && index && !refine) {
+        // Index hits cover every entry; keep the ones in the subgroup tree.
+        for (int idx : index->search(store, view->pathQuery)) {
+            if (tree.parentOf(idx) >= 0) {
+                matches.push_back(idx);
+            }
+        }
+    } else {
+        const QVector<int> &candidates = refine ? base->matches : subgroups->indexes;
+        matches.reserve(candidates.size());
+        int scanned = 0;
+        for (int idx : candidates) {
+            if ((++scanned & 0xfff) == 0 && latest && latest->load() != generation) {
+                return nullptr;
+            }
+            const bool hit = pathMode ? view->pathQuery.matches(store.path(idx), store.entry(idx).sourcePath)
+                                      : store.baseNameLower(idx).contains(view->filterLower);
+            if (hit) {
+                matches.push_back(idx);
+            }
+        }
+    }
+
+    // Mark every directory that has a matching entry somewhere below it (and,
+    // for path queries, matching directories themselves); the walk up stops
+    // at the first directory already marked.
+    view->entryMatches.assign(size_t(store.count()), 0);
+    for (int idx : matches) {
+        view->entryMatches[size_t(idx)] = 1;
+        int dir = tree.parentOf(idx);
+        if (pathMode && store.ftype(idx) == 'd') {
+            dir = tree.findDir(store.path(idx).toString());
+        }
+        for (; dir > 0 && !view->matchDirs[size_t(dir)]; dir = tree.node(dir).parent) {
+            view->matchDirs[size_t(dir)] = 1;
+        }
+    }
+    return view;
+}
+
+QVector<int> NameView::rows(const QString &currentDir, int dirId) const {
+    const DirectoryTree &tree = subgroups->tree;
+    QVector<int> out;
+
+    if (!currentDir.isEmpty()) {
+        out.push_back(-1);
+    }
+    if (dirId < 0) {
+        return out;
+    }
+    const DirectoryTree::Node &dir = tree.node(dirId);
+    const bool filtered = !filterLower.isEmpty();
+    out.reserve(out.size() + int(dir.dirs.size() + dir.files.size()));
+
+    for (size_t i = 0; i < dir.dirs.size(); ++i) {
+        const int childId = dir.dirs[i];
+        if (filtered && !matchDirs[size_t(childId)] &&
+            !(pathQuery.isEmpty() && tree.node(childId).name.contains(filter, Qt::CaseInsensitive))) {
+            continue;
+        }
+        out.push_back(int(i));
+    }
+
+    for (size_t i = 0; i < dir.files.size(); ++i) {
+        if (filtered && !entryMatches[size_t(dir.files[i])]) {
+            continue;
+        }
+        out.push_back(int(dir.dirs.size() + i));
+    }
+    return out;
+}
+
+} // namespace swcore
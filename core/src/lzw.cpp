@@ -0,0 +1,465 @@
+#include "swcore/lzw.h"
+
+#include <QtEndian>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace swcore {
+
+namespace {
+
+constexpr int kHeaderSize = 3;
+constexpr int kInitBits = 9;
+constexpr int kClearCode = 256;
+constexpr int kFirstCode = 257;
+// Bound on the output reserved up front from an idb size hint, relative to
+// the compressed size; a bogus hint costs no more than this, and real
+// outputs beyond it grow the buffer as usual.
+constexpr qint64 kMaxHintRatio = 16;
+
+// One dictionary slot. Every string the decoder emits stays in the output
+// buffer, so a code is stored as the position of its first occurrence plus
+// its length and is re-emitted with a single memcpy.
+struct CodeString {
+    qint64 pos = 0;
+    quint32 length = 0;
+    quint8 first = 0;
+};
+
+// Reads the next little-endian code at an absolute bit position. Codes never
+// straddle more than three bytes, so one 64-bit load covers them.
+inline quint32 peekBits(const uchar *data, qint64 size, qint64 bitPos) {
+    const qint64 byte = bitPos >> 3;
+    quint64 buf = 0;
+    if (byte + 8 <= size) {
+        buf = qFromLittleEndian<quint64>(data + byte);
+    } else {
+        for (qint64 i = 0; byte + i < size; ++i) {
+            buf |= quint64(data[byte + i]) << (8 * i);
+        }
+    }
+    return quint32(buf >> (bitPos & 7));
+}
+
+class OutputBuffer {
+public:
+    explicit OutputBuffer(qint64 sizeHint) {
+        m_bytes.resize(int(std::min<qint64>(std::max<qint64>(sizeHint, 4096), 0x7fffffff / 2)));
+        m_data = m_bytes.data();
+    }
+
+    char *reserve(qint64 n) {
+        if (m_pos + n > m_bytes.size()) {
+            const qint64 want = std::max<qint64>(m_pos + n, qint64(m_bytes.size()) * 2);
+            if (want > 0x7fffffff) {
+                throw std::runtime_error("LZW output too large");
+            }
+            m_bytes.resize(int(want));
+            m_data = m_bytes.data();
+        }
+        return m_data + m_pos;
+    }
+
+    const char *data() const { return m_data; }
+    qint64 pos() const { return m_pos; }
+    void advance(qint64 n) { m_pos += n; }
+
+    QByteArray take() {
+        m_bytes.resize(int(m_pos));
+        return std::move(m_bytes);
+    }
+
+private:
+    QByteArray m_bytes;
+    char *m_data = nullptr;
+    qint64 m_pos = 0;
+};
+
+} // namespace
+
+bool isCompressStream(const char *data, qint64 size) {
+    return data && size >= 2 && quint8(data[0]) == 0x1F && quint8(data[1]) == 0x9D;
+}
+
+bool isCompressStream(const QByteArray &data) {
+    return isCompressStream(data.constData(), data.size());
+}
+
+QByteArray unlzw(const QByteArray &input, qint64 sizeHint) {
+    if (input.size() < kHeaderSize || !isCompressStream(input)) {
+        throw std::runtime_error("Not a .Z stream");
+    }
+
+    const int flags = quint8(input.at(2));
+    const int maxbits = flags & 0x1F;
+    const bool blockMode = (flags & 0x80) != 0;
+    if (maxbits < kInitBits || maxbits > 16) {
+        throw std::runtime_error("Unsupported .Z maxbits");
+    }
+
+    const uchar *in = reinterpret_cast<const uchar *>(input.constData()) + kHeaderSize;
+    const qint64 inSize = input.size() - kHeaderSize;
+    const int maxMaxCode = 1 << maxbits;
+
+    std::vector<CodeString> table(maxMaxCode);
+    for (int i = 0; i < 256; ++i) {
+        table[i].length = 1;
+        table[i].first = quint8(i);
+    }
+
+    OutputBuffer out(sizeHint > 0 ? std::min(sizeHint, inSize * kMaxHintRatio) : inSize * 3);
+
+    int nBits = kInitBits;
+    int maxCode = (1 << nBits) - 1;
+    int freeEnt = blockMode ? kFirstCode : 256;
+    bool clearFlag = false;
+
+    // Codes are packed in groups of nBits bytes (eight codes). A width change
+    // or CLEAR discards the rest of the current group, exactly like ncompress.
+    qint64 groupStart = 0;
+    qint64 groupBytes = 0;
+    qint64 bitPos = 0;
+    int codesLeft = 0;
+
+    int oldCode = -1;
+    qint64 oldPos = 0;
+
+    while (true) {
+        if (clearFlag || codesLeft <= 0 || freeEnt > maxCode) {
+            if (freeEnt > maxCode) {
+                ++nBits;
+                maxCode = nBits == maxbits ? maxMaxCode : (1 << nBits) - 1;
+            }
+            if (clearFlag) {
+                nBits = kInitBits;
+                maxCode = (1 << nBits) - 1;
+                clearFlag = false;
+            }
+
+            groupStart += groupBytes;
+            const qint64 remain = inSize - groupStart;
+            if (remain <= 0) {
+                break;
+            }
+            groupBytes = std::min<qint64>(nBits, remain);
+            const qint64 groupBits = (groupBytes << 3) - (nBits - 1);
+            if (groupBits <= 0) {
+                break;
+            }
+            codesLeft = int((groupBits + nBits - 1) / nBits);
+            bitPos = groupStart << 3;
+        }
+
+        int code = int(peekBits(in, inSize, bitPos) & ((1u << nBits) - 1));
+        bitPos += nBits;
+        --codesLeft;
+
+        if (blockMode && code == kClearCode) {
+            clearFlag = true;
+            freeEnt = kFirstCode;
+            oldCode = -1;
+            continue;
+        }
+
+        const qint64 pos = out.pos();
+
+        if (oldCode < 0) {
+            if (code > 255) {
+                throw std::runtime_error("Corrupt .Z stream");
+            }
+            *out.reserve(1) = char(code);
+            out.advance(1);
+            oldCode = code;
+            oldPos = pos;
+            continue;
+        }
+
+        if (code < freeEnt) {
+            const CodeString &s = table[code];
+            char *dst = out.reserve(s.length);
+            if (code < 256) {
+                *dst = char(code);
+            } else {
+                std::memcpy(dst, out.data() + s.pos, s.length);
+            }
+            out.advance(s.length);
+        } else {
+            if (code != freeEnt) {
+                throw std::runtime_error("LZW decode error");
+            }
+            // KwKwK: the previous string followed by its own first character.
+            const CodeString &prev = table[oldCode];
+            char *dst = out.reserve(qint64(prev.length) + 1);
+            std::memcpy(dst, out.data() + oldPos, prev.length);
+            dst[prev.length] = char(prev.first);
+            out.advance(qint64(prev.length) + 1);
+        }
+
+        if (freeEnt < maxMaxCode) {
+            // The new string is the previous one plus the first character of
+            // this one, which already sits contiguously in the output at oldPos.
+            CodeString &s = table[freeEnt];
+            s.pos = oldPos;
+            s.length = table[oldCode].length + 1;
+            s.first = table[oldCode].first;
+            ++freeEnt;
+        }
+
+        oldCode = code;
+        oldPos = pos;
+    }
+
+    return out.take();
+}
+
+void LzwDecoder::reset() {
+    m_in.clear();
+    m_view = nullptr;
+    m_viewSize = 0;
+    m_pendingPos = 0;
+    m_pendingLen = 0;
+    m_headerDone = false;
+    m_finished = false;
+    m_ended = false;
+    m_clearFlag = false;
+    m_oldCode = -1;
+    m_groupStart = 0;
+    m_groupBytes = 0;
+    m_bitPos = 0;
+    m_codesLeft = 0;
+}
+
+void LzwDecoder::feed(const char *data, qint64 size) {
+    if (!data || size <= 0) {
+        return;
+    }
+    compactInput();
+    if (m_view) {
+        // Take ownership of the unconsumed tail of a borrowed view.
+        m_in.assign(m_view + m_groupStart, m_view + m_viewSize);
+        m_bitPos -= m_groupStart << 3;
+        m_groupStart = 0;
+        m_view = nullptr;
+        m_viewSize = 0;
+    }
+    m_in.insert(m_in.end(), reinterpret_cast<const uchar *>(data), reinterpret_cast<const uchar *>(data) + size);
+}
+
+void LzwDecoder::feedView(const char *data, qint64 size) {
+    if (!data || size <= 0) {
+        return;
+    }
+    if (m_view || !m_in.empty()) {
+        feed(data, size);
+        return;
+    }
+    m_view = reinterpret_cast<const uchar *>(data);
+    m_viewSize = size;
+    m_bitPos -= m_groupStart << 3;
+    m_groupStart = 0;
+    m_groupBytes = 0;
+}
+
+void LzwDecoder::finish() {
+    m_finished = true;
+}
+
+bool LzwDecoder::atEnd() const {
+    return m_ended && m_pendingPos >= m_pendingLen;
+}
+
+const uchar *LzwDecoder::inputData() const {
+    return m_view ? m_view : m_in.data();
+}
+
+qint64 LzwDecoder::inputSize() const {
+    return m_view ? m_viewSize : qint64(m_in.size());
+}
+
+void LzwDecoder::compactInput() {
+    // Everything before the current group has been consumed.
+    if (m_view || m_groupStart == 0 || m_groupStart * 2 < qint64(m_in.size())) {
+        return;
+    }
+    m_in.erase(m_in.begin(), m_in.begin() + m_groupStart);
+    m_bitPos -= m_groupStart << 3;
+    m_groupStart = 0;
+}
+
+bool LzwDecoder::readHeader() {
+    if (inputSize() < kHeaderSize) {
+        if (m_finished) {
+            throw std::runtime_error("Not a .Z stream");
+        }
+        return false;
+    }
+    const uchar *in = inputData();
+    if (in[0] != 0x1F || in[1] != 0x9D) {
+        throw std::runtime_error("Not a .Z stream");
+    }
+    const int flags = in[2];
+    m_maxBits = flags & 0x1F;
+    m_blockMode = (flags & 0x80) != 0;
+    if (m_maxBits < kInitBits || m_maxBits > 16) {
+        throw std::runtime_error("Unsupported .Z maxbits");
+    }
+    m_groupStart = kHeaderSize;
+    m_groupBytes = 0;
+
+    m_maxMaxCode = 1 << m_maxBits;
+    m_table.resize(size_t(m_maxMaxCode));
+    for (int i = 0; i < 256; ++i) {
+        m_table[i].length = 1;
+        m_table[i].first = quint8(i);
+    }
+    m_pending.resize(size_t(m_maxMaxCode));
+
+    m_nBits = kInitBits;
+    m_maxCode = (1 << m_nBits) - 1;
+    m_freeEnt = m_blockMode ? kFirstCode : 256;
+    m_headerDone = true;
+    return true;
+}
+
+bool LzwDecoder::beginGroup() {
+    int nBits = m_nBits;
+    int maxCode = m_maxCode;
+    if (m_freeEnt > maxCode) {
+        ++nBits;
+        maxCode = nBits == m_maxBits ? m_maxMaxCode : (1 << nBits) - 1;
+    }
+    if (m_clearFlag) {
+        nBits = kInitBits;
+        maxCode = (1 << nBits) - 1;
+    }
+
+    // Only a full group may be started before the end of input is known;
+    // a short final group is decoded differently.
+    const qint64 start = m_groupStart + m_groupBytes;
+    const qint64 remain = inputSize() - start;
+    if (remain < nBits && !m_finished) {
+        return false;
+    }
+
+    m_nBits = nBits;
+    m_maxCode = maxCode;
+    m_clearFlag = false;
+    m_groupStart = start;
+    m_groupBytes = 0;
+    m_codesLeft = 0;
+    if (remain <= 0) {
+        m_ended = true;
+        return false;
+    }
+    m_groupBytes = std::min<qint64>(nBits, remain);
+    const qint64 groupBits = (m_groupBytes << 3) - (nBits - 1);
+    if (groupBits <= 0) {
+        m_ended = true;
+        return false;
+    }
+    m_codesLeft = int((groupBits + nBits - 1) / nBits);
+    m_bitPos = start << 3;
+    return true;
+}
+
+void LzwDecoder::writeString(int code, char *dst) const {
+    // The cached length lets the prefix chain be written back to front
+    // without an intermediate stack.
+    char *p = dst + m_table[code].length - 1;
+    while (code >= 256) {
+        *p-- = char(m_table[code].suffix);
+        code = m_table[code].prefix;
+    }
+    *p = char(code);
+}
+
+qint64 LzwDecoder::drain(char *out, qint64 capacity) {
+    if (!out || capacity <= 0) {
+        return 0;
+    }
+
+    qint64 written = 0;
+    if (m_pendingPos < m_pendingLen) {
+        const qint64 n = std::min(capacity, m_pendingLen - m_pendingPos);
+        std::memcpy(out, m_pending.data() + m_pendingPos, size_t(n));
+        m_pendingPos += n;
+        written += n;
+    }
+
+    if (m_ended || (!m_headerDone && !readHeader())) {
+        return written;
+    }
+
+    while (written < capacity) {
+        if (m_clearFlag || m_codesLeft <= 0 || m_freeEnt > m_maxCode) {
+            if (!beginGroup()) {
+                break;
+            }
+        }
+
+        const int code = int(peekBits(inputData(), inputSize(), m_bitPos) & ((1u << m_nBits) - 1));
+        m_bitPos += m_nBits;
+        --m_codesLeft;
+
+        if (m_blockMode && code == kClearCode) {
+            m_clearFlag = true;
+            m_freeEnt = kFirstCode;
+            m_oldCode = -1;
+            continue;
+        }
+
+        if (m_oldCode < 0) {
+            if (code > 255) {
+                throw std::runtime_error("Corrupt .Z stream");
+            }
+            out[written++] = char(code);
+            m_oldCode = code;
+            continue;
+        }
+
+        const bool kwkwk = code >= m_freeEnt;
+        if (kwkwk && code != m_freeEnt) {
+            throw std::runtime_error("LZW decode error");
+        }
+        const Code &old = m_table[m_oldCode];
+        const qint64 length = kwkwk ? qint64(old.length) + 1 : qint64(m_table[code].length);
+
+        // Strings that do not fit the caller's buffer are staged and handed
+        // out by the following drain() calls.
+        const bool spill = written + length > capacity;
+        char *dst = spill ? m_pending.data() : out + written;
+        if (kwkwk) {
+            writeString(m_oldCode, dst);
+            dst[length - 1] = char(old.first);
+        } else {
+            writeString(code, dst);
+        }
+
+        if (m_freeEnt < m_maxMaxCode) {
+            Code &entry = m_table[m_freeEnt];
+            entry.prefix = quint16(m_oldCode);
+            entry.suffix = quint8(dst[0]);
+            entry.first = old.first;
+            entry.length = old.length + 1;
+            ++m_freeEnt;
+        }
+        m_oldCode = code;
+
+        if (spill) {
+            const qint64 n = capacity - written;
+            std::memcpy(out + written, dst, size_t(n));
+            written = capacity;
+            m_pendingPos = n;
+            m_pendingLen = length;
+            break;
+        }
+        written += length;
+    }
+
+    return written;
+}
+
+} // namespace swcore
@@ -0,0 +1,476 @@
+#include "swcore/output_tree.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileDevice>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SW_OUTPUT_AT_CALLS
+#endif
+
+namespace swcore {
+
+namespace {
+
+// Bounds the descriptors held open; evicted directories are reopened from
+// their parent when needed again.
+constexpr int kMaxOpenDirs = 256;
+
+#ifdef SW_OUTPUT_AT_CALLS
+// Output files are written as ".sw-<pid>-<n>.tmp" next to their target.
+constexpr char kTempPrefix[] = ".sw-";
+constexpr char kTempSuffix[] = ".tmp";
+// A writer keeps touching its temporary; one left alone this long is not
+// being written, whatever host or PID namespace it came from.
+constexpr time_t kStaleTempAge = 60 * 60;
+
+// A temporary left by a crash or kill: untouched for kStaleTempAge, and its
+// pid is not a live process here (on another NFS client or in another PID
+// namespace the pid says nothing, so the age is what protects those).
+bool isStaleTemp(int dirFd, const char *name, time_t now) {
+    const size_t prefix = sizeof(kTempPrefix) - 1;
+    if (std::strncmp(name, kTempPrefix, prefix) != 0) {
+        return false;
+    }
+    char *end = nullptr;
+    const long pid = std::strtol(name + prefix, &end, 10);
+    if (end == name + prefix || *end != '-' || !QByteArray(end).endsWith(kTempSuffix)) {
+        return false;
+    }
+    if (pid == long(::getpid())) {
+        return false;
+    }
+    struct stat st;
+    if (::fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) != 0 || !S_ISREG(st.st_mode) ||
+        now - st.st_mtime < kStaleTempAge) {
+        return false;
+    }
+    return pid <= 0 || (::kill(pid_t(pid), 0) != 0 && errno == ESRCH);
+}
+
+void removeStaleTemps(int dirFd) {
+    const int fd = ::openat(dirFd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    DIR *dir = ::fdopendir(fd);
+    if (!dir) {
+        ::close(fd);
+        return;
+    }
+    const time_t now = ::time(nullptr);
+    std::vector<QByteArray> stale;
+    while (const dirent *entry = ::readdir(dir)) {
+        if (isStaleTemp(dirFd, entry->d_name, now)) {
+            stale.emplace_back(entry->d_name);
+        }
+    }
+    ::closedir(dir);
+    for (const QByteArray &name : stale) {
+        ::unlinkat(dirFd, name.constData(), 0);
+    }
+}
+#endif
+
+void splitPath(const QString &relPath, QString *parent, QString *name) {
+    const int slash = relPath.lastIndexOf('/');
+    *parent = slash < 0 ? QString() : relPath.left(slash);
+    *name = relPath.mid(slash + 1);
+}
+
+#ifndef SW_OUTPUT_AT_CALLS
+QFileDevice::Permissions modeToPermissions(int mode) {
+    QFileDevice::Permissions p;
+    if (mode & 0400) p |= QFileDevice::ReadOwner;
+    if (mode & 0200) p |= QFileDevice::WriteOwner;
+    if (mode & 0100) p |= QFileDevice::ExeOwner;
+    if (mode & 0040) p |= QFileDevice::ReadGroup;
+    if (mode & 0020) p |= QFileDevice::WriteGroup;
+    if (mode & 0010) p |= QFileDevice::ExeGroup;
+    if (mode & 0004) p |= QFileDevice::ReadOther;
+    if (mode & 0002) p |= QFileDevice::WriteOther;
+    if (mode & 0001) p |= QFileDevice::ExeOther;
+    return p;
+}
+#endif
+
+} // namespace
+
+struct OutputTree::DirHandle {
+    DirHandle() = default;
+    DirHandle(const DirHandle &) = delete;
+    DirHandle &operator=(const DirHandle &) = delete;
+    ~DirHandle() {
+#ifdef SW_OUTPUT_AT_CALLS
+        if (fd >= 0) {
+            ::close(fd);
+        }
+#endif
+    }
+
+    int fd = -1;
+};
+
+OutputTree::OutputTree(const QString &root) : m_root(root) {
+    if (!QDir().mkpath(m_root)) {
+        return;
+    }
+    auto handle = std::make_shared<DirHandle>();
+#ifdef SW_OUTPUT_AT_CALLS
+    handle->fd = ::open(QFile::encodeName(m_root).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (handle->fd < 0) {
+        return;
+    }
+#endif
+    makeWritable(QString(), *handle);
+    sweepOnce(QString(), *handle);
+    m_rootHandle = std::move(handle);
+}
+
+OutputTree::~OutputTree() = default;
+
+bool OutputTree::isValid() const {
+    return m_rootHandle != nullptr;
+}
+
+QString OutputTree::absolutePath(const QString &relPath) const {
+    return relPath.isEmpty() ? m_root : QDir(m_root).filePath(relPath);
+}
+
+bool OutputTree::ensureDir(const QString &relDir) {
+    return dirHandle(relDir) != nullptr;
+}
+
+bool OutputTree::createSymlink(const QString &relPath, const QString &target) {
+    QString parentRel;
+    QString name;
+    splitPath(relPath, &parentRel, &name);
+    const std::shared_ptr<DirHandle> parent = relPath.isEmpty() ? nullptr : dirHandle(parentRel);
+    if (!parent) {
+        return false;
+    }
+#ifdef SW_OUTPUT_AT_CALLS
+    const QByteArray encoded = QFile::encodeName(name);
+    ::unlinkat(parent->fd, encoded.constData(), 0);
+    return ::symlinkat(QFile::encodeName(target).constData(), parent->fd, encoded.constData()) == 0;
+#else
+    const QString path = absolutePath(relPath);
+    QFile::remove(path);
+    return QFile::link(target, path);
+#endif
+}
+
+void OutputTree::setDirMode(const QString &relDir, int mode) {
+    QMutexLocker locker(&m_mutex);
+    m_pendingModes.insert(relDir, mode & 0777);
+}
+
+void OutputTree::applyMetadata() {
+    std::vector<std::pair<QString, int>> pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        pending.reserve(size_t(m_pendingModes.size()));
+        for (auto it = m_pendingModes.cbegin(); it != m_pendingModes.cend(); ++it) {
+            pending.emplace_back(it.key(), it.value());
+        }
+        m_pendingModes.clear();
+    }
+
+    // Deepest first: a directory is never reopened through a parent whose
+    // mode has already been applied.
+    const auto depth = [](const QString &relDir) { return relDir.isEmpty() ? -1 : int(relDir.count('/')); };
+    std::sort(pending.begin(), pending.end(), [&depth](const auto &a, const auto &b) {
+        return depth(a.first) > depth(b.first);
+    });
+
+    for (const auto &dir : pending) {
+#ifdef SW_OUTPUT_AT_CALLS
+        const std::shared_ptr<DirHandle> handle = dirHandle(dir.first);
+        if (handle) {
+            ::fchmod(handle->fd, mode_t(dir.second));
+        }
+#else
+        QFile(absolutePath(dir.first)).setPermissions(modeToPermissions(dir.second));
+#endif
+    }
+}
+
+std::shared_ptr<OutputTree::DirHandle> OutputTree::dirHandle(const QString &relDir) {
+    if (relDir.isEmpty()) {
+        return m_rootHandle;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        const auto it = m_dirs.constFind(relDir);
+        if (it != m_dirs.constEnd()) {
+            return it.value();
+        }
+    }
+
+    std::shared_ptr<DirHandle> handle = openDir(relDir);
+    if (!handle) {
+        return nullptr;
+    }
+
+    // Handles stay valid for their current users after eviction.
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_dirs.constFind(relDir);
+    if (it != m_dirs.constEnd()) {
+        return it.value();
+    }
+    m_dirs.insert(relDir, handle);
+    m_order.push_back(relDir);
+    while (m_order.size() > size_t(kMaxOpenDirs)) {
+        m_dirs.remove(m_order.front());
+        m_order.pop_front();
+    }
+    return handle;
+}
+
+std::shared_ptr<OutputTree::DirHandle> OutputTree::openDir(const QString &relDir) {
+    if (!m_rootHandle) {
+        return nullptr;
+    }
+    QString parentRel;
+    QString name;
+    splitPath(relDir, &parentRel, &name);
+    const std::shared_ptr<DirHandle> parent = dirHandle(parentRel);
+    if (!parent) {
+        return nullptr;
+    }
+
+    auto handle = std::make_shared<DirHandle>();
+#ifdef SW_OUTPUT_AT_CALLS
+    const QByteArray encoded = QFile::encodeName(name);
+    bool existed = false;
+    if (::mkdirat(parent->fd, encoded.constData(), 0777) != 0) {
+        if (errno != EEXIST) {
+            return nullptr;
+        }
+        existed = true;
+    }
+    handle->fd = ::openat(parent->fd, encoded.constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (handle->fd < 0) {
+        return nullptr;
+    }
+    if (existed) {
+        makeWritable(relDir, *handle);
+        sweepOnce(relDir, *handle);
+    }
+#else
+    if (!QDir().mkpath(absolutePath(relDir))) {
+        return nullptr;
+    }
+#endif
+    return handle;
+}
+
+// A directory left read-only by an earlier run would refuse the new files;
+// its mode is restored by applyMetadata() unless this run sets another.
+void OutputTree::makeWritable(const QString &relDir, const DirHandle &handle) {
+#ifdef SW_OUTPUT_AT_CALLS
+    struct stat st;
+    if (::fstat(handle.fd, &st) != 0 || (st.st_mode & S_IRWXU) == S_IRWXU) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_pendingModes.contains(relDir)) {
+            m_pendingModes.insert(relDir, int(st.st_mode & 07777));
+        }
+    }
+    ::fchmod(handle.fd, st.st_mode | S_IRWXU);
+#else
+    Q_UNUSED(relDir);
+    Q_UNUSED(handle);
+#endif
+}
+
+void OutputTree::sweepOnce(const QString &relDir, const DirHandle &handle) {
+#ifdef SW_OUTPUT_AT_CALLS
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_swept.contains(relDir)) {
+            return;
+        }
+        m_swept.insert(relDir);
+    }
+    removeStaleTemps(handle.fd);
+#else
+    Q_UNUSED(relDir);
+    Q_UNUSED(handle);
+#endif
+}
+
+OutputFile::OutputFile(OutputTree *tree, const QString &relPath) : m_tree(tree), m_relPath(relPath) {}
+
+OutputFile::~OutputFile() {
+    discard();
+}
+
+QString OutputFile::fileName() const {
+    return m_tree->absolutePath(m_relPath);
+}
+
+bool OutputFile::open(QString *error) {
+    if (m_relPath.isEmpty()) {
+        if (error) {
+            *error = QString("Output path is a directory: %1").arg(fileName());
+        }
+        return false;
+    }
+    QString parentRel;
+    QString name;
+    splitPath(m_relPath, &parentRel, &name);
+    m_parent = m_tree->dirHandle(parentRel);
+    if (!m_parent) {
+        if (error) {
+            *error = QString("Cannot create parent directory for %1").arg(fileName());
+        }
+        return false;
+    }
+
+#ifdef SW_OUTPUT_AT_CALLS
+    m_name = QFile::encodeName(name);
+    struct stat st;
+    if (::fstatat(m_parent->fd, m_name.constData(), &st, 0) == 0 && S_ISDIR(st.st_mode)) {
+        if (error) {
+            *error = QString("Output path is a directory: %1").arg(fileName());
+        }
+        return false;
+    }
+
+    // The target is replaced by rename, so a read-only file already there
+    // does not need its mode changed first.
+    static std::atomic<quint32> counter{0};
+    for (int attempt = 0; attempt < 16 && m_fd < 0; ++attempt) {
+        m_tempName = kTempPrefix + QByteArray::number(qint64(::getpid())) + '-' +
+                     QByteArray::number(counter.fetch_add(1, std::memory_order_relaxed)) + kTempSuffix;
+        m_fd = ::openat(m_parent->fd, m_tempName.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+        if (m_fd < 0 && errno != EEXIST) {
+            break;
+        }
+    }
+    if (m_fd < 0) {
+        m_tempName.clear();
+        if (error) {
+            *error = QString("Cannot open output file %1").arg(fileName());
+        }
+        return false;
+    }
+    return true;
+#else
+    const QString path = fileName();
+    const QFileInfo fi(path);
+    if (fi.exists()) {
+        if (fi.isDir()) {
+            if (error) {
+                *error = QString("Output path is a directory: %1").arg(path);
+            }
+            return false;
+        }
+        QFile existing(path);
+        existing.setPermissions(existing.permissions() | QFileDevice::WriteOwner);
+    }
+    m_fallback = std::make_unique<QSaveFile>(path);
+    if (!m_fallback->open(QIODevice::WriteOnly)) {
+        m_fallback.reset();
+        if (error) {
+            *error = QString("Cannot open output file %1").arg(path);
+        }
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool OutputFile::write(const char *data, qint64 size) {
+#ifdef SW_OUTPUT_AT_CALLS
+    if (m_fd < 0) {
+        return false;
+    }
+    while (size > 0) {
+        const ssize_t n = ::write(m_fd, data, size_t(size));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= n;
+    }
+    return true;
+#else
+    return m_fallback && m_fallback->write(data, size) == size;
+#endif
+}
+
+bool OutputFile::setMode(int mode) {
+#ifdef SW_OUTPUT_AT_CALLS
+    return m_fd >= 0 && ::fchmod(m_fd, mode_t(mode & 0777)) == 0;
+#else
+    m_mode = mode;
+    return m_fallback != nullptr;
+#endif
+}
+
+bool OutputFile::commit() {
+#ifdef SW_OUTPUT_AT_CALLS
+    if (m_fd < 0) {
+        return false;
+    }
+    const bool closed = ::close(m_fd) == 0;
+    m_fd = -1;
+    if (!closed || ::renameat(m_parent->fd, m_tempName.constData(), m_parent->fd, m_name.constData()) != 0) {
+        discard();
+        return false;
+    }
+    m_tempName.clear();
+    return true;
+#else
+    if (!m_fallback) {
+        return false;
+    }
+    const bool committed = m_fallback->commit();
+    m_fallback.reset();
+    if (committed && m_mode >= 0) {
+        QFile(fileName()).setPermissions(modeToPermissions(m_mode));
+    }
+    return committed;
+#endif
+}
+
+void OutputFile::discard() {
+#ifdef SW_OUTPUT_AT_CALLS
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    if (!m_tempName.isEmpty() && m_parent) {
+        ::unlinkat(m_parent->fd, m_tempName.constData(), 0);
+        m_tempName.clear();
+    }
+#else
+    m_fallback.reset();
+#endif
+}
+
+} // namespace swcore
@@ -0,0 +1,133 @@
+#include "swcore/path_index.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace swcore {
+
+namespace {
+
+quint64 trigramAt(const QChar *s) {
+    return (quint64(s[0].unicode()) << 32) | (quint64(s[1].unicode()) << 16) | quint64(s[2].unicode());
+}
+
+void appendTrigrams(const QString &folded, std::vector<quint64> *out) {
+    for (int i = 0; i + 3 <= folded.size(); ++i) {
+        out->push_back(trigramAt(folded.constData() + i));
+    }
+}
+
+void intersectInto(std::vector<quint32> *acc, const std::vector<quint32> &other) {
+    std::vector<quint32> merged;
+    merged.reserve(std::min(acc->size(), other.size()));
+    std::set_intersection(acc->begin(), acc->end(), other.begin(), other.end(), std::back_inserter(merged));
+    acc->swap(merged);
+}
+
+} // namespace
+
+PathQuery::PathQuery(const QString &text) : m_text(text), m_folded(text.toCaseFolded()) {
+    m_glob = Wildcard::hasWildcards(m_folded);
+    if (m_glob) {
+        m_wildcard = Wildcard(m_folded);
+        m_literals = m_wildcard.literals();
+    } else if (!m_folded.isEmpty()) {
+        m_literals.push_back(m_folded);
+    }
+}
+
+bool PathQuery::matches(QStringView path, QStringView sourcePath) const {
+    if (m_folded.isEmpty()) {
+        return true;
+    }
+    if (!m_glob) {
+        return path.contains(m_text, Qt::CaseInsensitive) || sourcePath.contains(m_text, Qt::CaseInsensitive);
+    }
+    return m_wildcard.matches(path.toString().toCaseFolded()) ||
+           m_wildcard.matches(sourcePath.toString().toCaseFolded());
+}
+
+PathIndex::PathIndex(const EntryStore &store) : m_entryCount(store.count()) {
+    std::vector<quint64> grams;
+    for (int i = 0; i < store.count(); ++i) {
+        grams.clear();
+        appendTrigrams(store.path(i).toString().toCaseFolded(), &grams);
+        appendTrigrams(store.entry(i).sourcePath.toCaseFolded(), &grams);
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+        for (quint64 g : grams) {
+            m_postings[g].push_back(quint32(i));
+        }
+    }
+    for (auto it = m_postings.begin(); it != m_postings.end(); ++it) {
+        it.value().shrink_to_fit();
+    }
+}
+
+bool PathIndex::candidates(const QString &literal, std::vector<quint32> *out) const {
+    if (literal.size() < 3) {
+        return false;
+    }
+
+    std::vector<const std::vector<quint32> *> lists;
+    for (int i = 0; i + 3 <= literal.size(); ++i) {
+        const auto it = m_postings.constFind(trigramAt(literal.constData() + i));
+        if (it == m_postings.constEnd()) {
+            out->clear();
+            return true;
+        }
+        lists.push_back(&it.value());
+    }
+    std::sort(lists.begin(), lists.end(), [](const std::vector<quint32> *a, const std::vector<quint32> *b) {
+        return a->size() < b->size();
+    });
+
+    *out = *lists.front();
+    for (size_t i = 1; i < lists.size() && !out->empty(); ++i) {
+        intersectInto(out, *lists[i]);
+    }
+    return true;
+}
+
+std::vector<int> PathIndex::search(const EntryStore &store, const PathQuery &query) const {
+    std::vector<int> result;
+    if (query.isEmpty() || store.count() != m_entryCount) {
+        return result;
+    }
+
+    bool constrained = false;
+    std::vector<quint32> pool;
+    for (const QString &literal : query.literals()) {
+        std::vector<quint32> list;
+        if (!candidates(literal, &list)) {
+            continue;
+        }
+        if (constrained) {
+            intersectInto(&pool, list);
+        } else {
+            pool.swap(list);
+            constrained = true;
+        }
+        if (pool.empty()) {
+            return result;
+        }
+    }
+
+    auto verify = [&](int i) {
+        if (query.matches(store.path(i), store.entry(i).sourcePath)) {
+            result.push_back(i);
+        }
+    };
+    if (constrained) {
+        for (quint32 i : pool) {
+            verify(int(i));
+        }
+    } else {
+        for (int i = 0; i < m_entryCount; ++i) {
+            verify(i);
+        }
+    }
+    return result;
+}
+
+} // namespace swcore
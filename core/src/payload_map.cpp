@@ -0,0 +1,263 @@
+#include "swcore/payload_map.h"
+
+#include "swcore/payload_scan.h"
+#include "swcore/subproduct_file.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace swcore {
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'W', 'P', 'M', 'A', 'P', 0, 0};
+constexpr quint32 kFormatVersion = 1;
+constexpr quint32 kByteOrderMark = 0x01020304;
+// Maps kept in a cache directory; older ones are removed on store().
+constexpr int kMaxCachedMaps = 64;
+
+// Host byte order, like the idb index; the map is tied to the file's size
+// and mtime and rebuilt when either changes.
+struct MapHeader {
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    qint64 fileSize;
+    qint64 fileMtimeMs;
+    quint64 count;
+};
+
+struct MapRecord {
+    qint64 offset;
+    qint64 payloadSize;
+    qint64 header;
+    qint64 data;
+};
+
+static_assert(std::is_trivially_copyable<MapHeader>::value, "MapHeader must be POD");
+static_assert(sizeof(MapRecord) == 32, "MapRecord layout changed");
+
+QString mapPath(const QString &cacheDir, const QString &filePath) {
+    const QByteArray id =
+        QCryptographicHash::hash(QFileInfo(filePath).absoluteFilePath().toUtf8(), QCryptographicHash::Md5).toHex();
+    return QDir(cacheDir).filePath(QString::fromLatin1(id) + ".swmap");
+}
+
+qint64 mtimeMs(const SubproductFile &file) {
+    return QFileInfo(file.path()).lastModified().toMSecsSinceEpoch();
+}
+
+void pruneMaps(const QString &cacheDir) {
+    const QFileInfoList maps = QDir(cacheDir).entryInfoList({"*.swmap"}, QDir::Files, QDir::Time);
+    for (int i = kMaxCachedMaps; i < maps.size(); ++i) {
+        QFile::remove(maps.at(i).filePath());
+    }
+}
+
+bool headerStillMatches(SubproductFile &file, const PayloadMap::Location &location, const QList<QByteArray> &variants) {
+    const qint64 nameLength = location.data - location.header - 2;
+    for (const QByteArray &name : variants) {
+        if (name.size() == nameLength) {
+            return checkHeaderAt(file, location.header, name);
+        }
+    }
+    return false;
+}
+
+// Header of the entry's payload, expected at want; resyncs around want and
+// then tries the raw idb offset. Returns the header offset and sets *matched
+// to the name variant found there, or returns -1.
+qint64 locateHeader(SubproductFile &file,
+                    const FileEntry &entry,
+                    const QList<QByteArray> &variants,
+                    qint64 want,
+                    const ExtractOptions &options,
+                    QByteArray *matched) {
+    for (const QByteArray &name : variants) {
+        if (checkHeaderAt(file, want, name)) {
+            *matched = name;
+            return want;
+        }
+    }
+    const auto res = resyncOffset(file,
+                                  variants,
+                                  want,
+                                  options.resyncBack,
+                                  options.resyncForward,
+                                  std::max<qint64>(4096, options.resyncChunk));
+    if (res.has_value()) {
+        *matched = res->second;
+        return res->first;
+    }
+    if (want != entry.offset) {
+        for (const QByteArray &name : variants) {
+            if (checkHeaderAt(file, entry.offset, name)) {
+                *matched = name;
+                return entry.offset;
+            }
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+QString PayloadMap::defaultDirectory() {
+    QString base = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (base.isEmpty()) {
+        base = QDir(QDir::tempPath()).filePath("sw-explorer");
+    }
+    return QDir(base).filePath("payload-map");
+}
+
+PayloadMap PayloadMap::load(const QString &cacheDir, const SubproductFile &file) {
+    PayloadMap map;
+    QFile in(mapPath(cacheDir, file.path()));
+    if (!in.open(QIODevice::ReadOnly)) {
+        return map;
+    }
+    const QByteArray bytes = in.readAll();
+    if (bytes.size() < int(sizeof(MapHeader))) {
+        return map;
+    }
+
+    MapHeader hdr;
+    std::memcpy(&hdr, bytes.constData(), sizeof(hdr));
+    if (std::memcmp(hdr.magic, kMagic, sizeof(kMagic)) != 0 || hdr.version != kFormatVersion ||
+        hdr.byteOrder != kByteOrderMark || hdr.fileSize != file.size() || hdr.fileMtimeMs != mtimeMs(file) ||
+        hdr.count != (quint64(bytes.size()) - sizeof(MapHeader)) / sizeof(MapRecord)) {
+        return map;
+    }
+
+    map.m_locations.reserve(int(hdr.count));
+    const char *records = bytes.constData() + sizeof(MapHeader);
+    for (quint64 i = 0; i < hdr.count; ++i) {
+        MapRecord rec;
+        std::memcpy(&rec, records + i * sizeof(MapRecord), sizeof(rec));
+        if (rec.header < 0 || rec.data <= rec.header + 2 || rec.data > hdr.fileSize) {
+            return PayloadMap();
+        }
+        Record record;
+        record.payloadSize = rec.payloadSize;
+        record.location.header = rec.header;
+        record.location.data = rec.data;
+        map.m_locations.insert(rec.offset, record);
+    }
+    return map;
+}
+
+bool PayloadMap::store(const QString &cacheDir, const SubproductFile &file) const {
+    if (!QDir().mkpath(cacheDir)) {
+        return false;
+    }
+
+    MapHeader hdr;
+    std::memset(&hdr, 0, sizeof(hdr));
+    std::memcpy(hdr.magic, kMagic, sizeof(kMagic));
+    hdr.version = kFormatVersion;
+    hdr.byteOrder = kByteOrderMark;
+    hdr.fileSize = file.size();
+    hdr.fileMtimeMs = mtimeMs(file);
+    hdr.count = quint64(m_locations.size());
+
+    QByteArray out(int(sizeof(hdr)), '\0');
+    std::memcpy(out.data(), &hdr, sizeof(hdr));
+    out.reserve(int(sizeof(hdr) + hdr.count * sizeof(MapRecord)));
+    for (auto it = m_locations.cbegin(); it != m_locations.cend(); ++it) {
+        MapRecord rec;
+        rec.offset = it.key();
+        rec.payloadSize = it->payloadSize;
+        rec.header = it->location.header;
+        rec.data = it->location.data;
+        out.append(reinterpret_cast<const char *>(&rec), int(sizeof(rec)));
+    }
+
+    QSaveFile saved(mapPath(cacheDir, file.path()));
+    if (!saved.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    if (saved.write(out) != out.size() || !saved.commit()) {
+        return false;
+    }
+    pruneMaps(cacheDir);
+    return true;
+}
+
+const PayloadMap::Location *PayloadMap::find(const FileEntry &entry) const {
+    const auto it = m_locations.constFind(entry.offset);
+    if (it == m_locations.constEnd() || it->payloadSize != entry.payloadSize) {
+        return nullptr;
+    }
+    return &it->location;
+}
+
+bool PayloadMap::covers(SubproductFile &file, const QVector<const FileEntry *> &entries) const {
+    for (const FileEntry *entry : entries) {
+        const auto it = m_locations.constFind(entry->offset);
+        if (it == m_locations.constEnd() || it->payloadSize != entry->payloadSize ||
+            !headerStillMatches(file, it->location, nameVariants(entry->fname))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PayloadMap::walkChain(SubproductFile &file,
+                           const QVector<const FileEntry *> &chain,
+                           const ExtractOptions &options,
+                           QHash<qint64, QString> *errors) {
+    m_locations.clear();
+
+    // The idb lists records in file order; offsets only break ties.
+    QVector<const FileEntry *> records = chain;
+    std::stable_sort(records.begin(), records.end(), [](const FileEntry *a, const FileEntry *b) {
+        return a->offset < b->offset;
+    });
+
+    // File position minus idb arithmetic at the end of the last record read.
+    // Where the idb lists every record, the next header is expected exactly
+    // where that record ends.
+    qint64 drift = 0;
+    for (const FileEntry *entry : records) {
+        if (entry->payloadSize < 0 || entry->offset < 0) {
+            if (errors) {
+                errors->insert(entry->offset, "Invalid payload metadata");
+            }
+            continue;
+        }
+        if (m_locations.contains(entry->offset)) {
+            continue;
+        }
+
+        QByteArray matched;
+        const qint64 header =
+            locateHeader(file, *entry, nameVariants(entry->fname), entry->offset + drift, options, &matched);
+        if (header < 0) {
+            if (errors) {
+                errors->insert(entry->offset, QString("Out of sync at %1 (delta=%2)").arg(entry->offset).arg(drift));
+            }
+            continue;
+        }
+
+        Record record;
+        record.payloadSize = entry->payloadSize;
+        record.location.header = header;
+        record.location.data = header + 2 + matched.size();
+        m_locations.insert(entry->offset, record);
+
+        const qint64 idbEnd = entry->offset + 2 + entry->fname.size() + entry->payloadSize;
+        drift = record.location.data + entry->payloadSize - idbEnd;
+    }
+}
+
+} // namespace swcore
@@ -0,0 +1,300 @@
+#include "swcore/payload_scan.h"
+
+#include "swcore/subproduct_file.h"
+
+#include <QSet>
+#include <QtAlgorithms>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SW_SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 is used when the build targets it, or picked at run time on GCC and
+// Clang builds for plain x86-64.
+#if defined(__AVX2__)
+#define SW_SCAN_AVX2
+#define SW_SCAN_AVX2_TARGET
+#elif defined(SW_SCAN_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define SW_SCAN_AVX2
+#define SW_SCAN_AVX2_RUNTIME
+#define SW_SCAN_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+#ifdef SW_SCAN_AVX2
+#include <immintrin.h>
+#endif
+
+namespace swcore {
+
+namespace {
+
+constexpr int kMaxVectorPatterns = 4;
+
+// A name variant reduced to the bytes checked before a full comparison: both
+// length bytes and the first and last name bytes, at fixed distances from the
+// header start.
+struct Pattern {
+    const QByteArray *name = nullptr;
+    qint64 headerLength = 0;
+    char lenHi = 0;
+    char lenLo = 0;
+    char first = 0;
+    char last = 0;
+};
+
+bool anchorsMatch(const char *hdr, const Pattern &pattern) {
+    return hdr[0] == pattern.lenHi && hdr[1] == pattern.lenLo && hdr[2] == pattern.first &&
+           hdr[pattern.headerLength - 1] == pattern.last;
+}
+
+// Moves *pos to the next header start whose anchors match one of the
+// patterns and returns true. Returns false with *pos where a full block no
+// longer fits; the caller checks the remaining positions one by one.
+using CandidateScan =
+    bool (*)(const char *data, qint64 size, qint64 maxHeader, const Pattern *patterns, int count, qint64 *pos);
+
+#ifdef SW_SCAN_SSE2
+bool nextCandidateSse2(const char *data, qint64 size, qint64 maxHeader, const Pattern *patterns, int count, qint64 *pos) {
+    __m128i lenHi[kMaxVectorPatterns];
+    __m128i lenLo[kMaxVectorPatterns];
+    __m128i first[kMaxVectorPatterns];
+    __m128i last[kMaxVectorPatterns];
+    for (int k = 0; k < count; ++k) {
+        lenHi[k] = _mm_set1_epi8(patterns[k].lenHi);
+        lenLo[k] = _mm_set1_epi8(patterns[k].lenLo);
+        first[k] = _mm_set1_epi8(patterns[k].first);
+        last[k] = _mm_set1_epi8(patterns[k].last);
+    }
+
+    qint64 i = *pos;
+    for (; i + 16 + maxHeader - 1 <= size; i += 16) {
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 1));
+        const __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 2));
+        __m128i hits = _mm_setzero_si128();
+        for (int k = 0; k < count; ++k) {
+            const __m128i tail =
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + patterns[k].headerLength - 1));
+            const __m128i len = _mm_and_si128(_mm_cmpeq_epi8(b0, lenHi[k]), _mm_cmpeq_epi8(b1, lenLo[k]));
+            const __m128i ends = _mm_and_si128(_mm_cmpeq_epi8(b2, first[k]), _mm_cmpeq_epi8(tail, last[k]));
+            hits = _mm_or_si128(hits, _mm_and_si128(len, ends));
+        }
+        const quint32 mask = quint32(_mm_movemask_epi8(hits));
+        if (mask != 0) {
+            *pos = i + qCountTrailingZeroBits(mask);
+            return true;
+        }
+    }
+    *pos = i;
+    return false;
+}
+#endif
+
+#ifdef SW_SCAN_AVX2
+SW_SCAN_AVX2_TARGET bool nextCandidateAvx2(const char *data,
+                                           qint64 size,
+                                           qint64 maxHeader,
+                                           const Pattern *patterns,
+                                           int count,
+                                           qint64 *pos) {
+    __m256i lenHi[kMaxVectorPatterns];
+    __m256i lenLo[kMaxVectorPatterns];
+    __m256i first[kMaxVectorPatterns];
+    __m256i last[kMaxVectorPatterns];
+    for (int k = 0; k < count; ++k) {
+        lenHi[k] = _mm256_set1_epi8(patterns[k].lenHi);
+        lenLo[k] = _mm256_set1_epi8(patterns[k].lenLo);
+        first[k] = _mm256_set1_epi8(patterns[k].first);
+        last[k] = _mm256_set1_epi8(patterns[k].last);
+    }
+
+    qint64 i = *pos;
+    for (; i + 32 + maxHeader - 1 <= size; i += 32) {
+        const __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + 1));
+        const __m256i b2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + 2));
+        __m256i hits = _mm256_setzero_si256();
+        for (int k = 0; k < count; ++k) {
+            const __m256i tail =
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + patterns[k].headerLength - 1));
+            const __m256i len = _mm256_and_si256(_mm256_cmpeq_epi8(b0, lenHi[k]), _mm256_cmpeq_epi8(b1, lenLo[k]));
+            const __m256i ends = _mm256_and_si256(_mm256_cmpeq_epi8(b2, first[k]), _mm256_cmpeq_epi8(tail, last[k]));
+            hits = _mm256_or_si256(hits, _mm256_and_si256(len, ends));
+        }
+        const quint32 mask = quint32(_mm256_movemask_epi8(hits));
+        if (mask != 0) {
+            *pos = i + qCountTrailingZeroBits(mask);
+            return true;
+        }
+    }
+    *pos = i;
+    return false;
+}
+#endif
+
+CandidateScan vectorScan() {
+#if defined(SW_SCAN_AVX2) && !defined(SW_SCAN_AVX2_RUNTIME)
+    return nextCandidateAvx2;
+#else
+#ifdef SW_SCAN_AVX2_RUNTIME
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    if (avx2) {
+        return nextCandidateAvx2;
+    }
+#endif
+#ifdef SW_SCAN_SSE2
+    return nextCandidateSse2;
+#else
+    return nullptr;
+#endif
+#endif
+}
+
+// Earliest header in data for the highest-priority pattern that occurs,
+// matching what searching for each variant in turn would return. Returns
+// the header offset and sets *hit, or returns -1.
+qint64 findHeader(const char *data,
+                  qint64 size,
+                  const std::vector<Pattern> &patterns,
+                  qint64 maxHeader,
+                  const Pattern **hit) {
+    int best = -1;
+    qint64 bestOffset = -1;
+    // Candidates are validated in place; stops at a hit for the first
+    // pattern since nothing later can beat it.
+    const auto check = [&](qint64 at) {
+        const int limit = best >= 0 ? best : int(patterns.size());
+        for (int k = 0; k < limit; ++k) {
+            const Pattern &pattern = patterns[size_t(k)];
+            if (at + pattern.headerLength <= size && anchorsMatch(data + at, pattern) &&
+                headerMatches(data + at, *pattern.name)) {
+                best = k;
+                bestOffset = at;
+                break;
+            }
+        }
+        return best == 0;
+    };
+
+    qint64 pos = 0;
+    static const CandidateScan scan = vectorScan();
+    bool done = false;
+    if (scan && patterns.size() <= size_t(kMaxVectorPatterns)) {
+        while (!done && scan(data, size, maxHeader, patterns.data(), int(patterns.size()), &pos)) {
+            done = check(pos);
+            ++pos;
+        }
+    }
+    for (; !done && pos < size; ++pos) {
+        done = check(pos);
+    }
+
+    *hit = best >= 0 ? &patterns[size_t(best)] : nullptr;
+    return bestOffset;
+}
+
+} // namespace
+
+bool headerMatches(const char *hdr, const QByteArray &nameBytes) {
+    const quint16 declaredLen = (quint16(quint8(hdr[0])) << 8) | quint16(quint8(hdr[1]));
+    return declaredLen == quint16(nameBytes.size()) &&
+           std::memcmp(hdr + 2, nameBytes.constData(), size_t(nameBytes.size())) == 0;
+}
+
+QList<QByteArray> nameVariants(const QString &name) {
+    const QByteArray raw = name.toLatin1();
+    QList<QByteArray> variants;
+    variants << raw << ("./" + raw) << ("/" + raw);
+
+    QList<QByteArray> unique;
+    QSet<QByteArray> seen;
+    for (const QByteArray &v : variants) {
+        if (!seen.contains(v)) {
+            unique.push_back(v);
+            seen.insert(v);
+        }
+    }
+    return unique;
+}
+
+bool checkHeaderAt(SubproductFile &file, qint64 offset, const QByteArray &nameBytes) {
+    if (offset < 0) {
+        return false;
+    }
+    const qint64 hdrLen = nameBytes.size() + 2;
+    if (file.isMapped()) {
+        const char *hdr = file.view(offset, hdrLen);
+        return hdr && headerMatches(hdr, nameBytes);
+    }
+    const QByteArray hdr = file.bytes(offset, hdrLen);
+    return hdr.size() == hdrLen && headerMatches(hdr.constData(), nameBytes);
+}
+
+std::optional<QPair<qint64, QByteArray>> resyncOffset(SubproductFile &file,
+                                                       const QList<QByteArray> &variants,
+                                                       qint64 baseOffset,
+                                                       qint64 back,
+                                                       qint64 forward,
+                                                       qint64 chunkSize) {
+    const qint64 scanStart = std::max<qint64>(0, baseOffset - back);
+    const qint64 scanEnd = std::min(file.size(), baseOffset + forward);
+    if (scanStart >= scanEnd) {
+        return std::nullopt;
+    }
+
+    // Variants keep their order, which decides between hits in one window.
+    std::vector<Pattern> patterns;
+    qint64 maxHeader = 0;
+    for (const QByteArray &v : variants) {
+        if (v.isEmpty() || v.size() > 0xFFFF) {
+            continue;
+        }
+        Pattern pattern;
+        pattern.name = &v;
+        pattern.headerLength = v.size() + 2;
+        pattern.lenHi = char((v.size() >> 8) & 0xFF);
+        pattern.lenLo = char(v.size() & 0xFF);
+        pattern.first = v.front();
+        pattern.last = v.back();
+        patterns.push_back(pattern);
+        maxHeader = std::max(maxHeader, pattern.headerLength);
+    }
+    if (patterns.empty()) {
+        return std::nullopt;
+    }
+
+    // A mapped file is scanned as one window; otherwise read it in chunks
+    // that overlap by one header.
+    if (file.isMapped()) {
+        chunkSize = scanEnd - scanStart;
+    }
+    qint64 pos = scanStart;
+
+    while (pos < scanEnd) {
+        const qint64 toRead = std::min(chunkSize, scanEnd - pos);
+        const QByteArray blob = file.bytes(pos, toRead);
+        if (blob.isEmpty()) {
+            break;
+        }
+
+        const Pattern *hit = nullptr;
+        const qint64 found = findHeader(blob.constData(), blob.size(), patterns, maxHeader, &hit);
+        if (hit) {
+            return QPair<qint64, QByteArray>(pos + found, *hit->name);
+        }
+
+        if (toRead <= maxHeader) {
+            break;
+        }
+        pos += toRead - maxHeader;
+    }
+
+    return std::nullopt;
+}
+
+} // namespace swcore
@@ -0,0 +1,28 @@
+#include "swcore/string_pool.h"
+
+namespace swcore {
+
+QString StringPool::intern(const char *latin1, int size) {
+    if (size <= 0) {
+        return {};
+    }
+    // The raw-data key only lives for the lookup; a miss stores a deep copy.
+    const auto it = m_strings.constFind(QByteArray::fromRawData(latin1, size));
+    if (it != m_strings.constEnd()) {
+        return it.value();
+    }
+    const QString value = QString::fromLatin1(latin1, size);
+    m_strings.insert(QByteArray(latin1, size), value);
+    return value;
+}
+
+QString StringPool::intern(const QString &s) {
+    const QByteArray latin1 = s.toLatin1();
+    if (QString::fromLatin1(latin1) != s) {
+        // Not representable in the pool's Latin-1 keys; keep it as is.
+        return s;
+    }
+    return intern(latin1.constData(), latin1.size());
+}
+
+} // namespace swcore
@@ -0,0 +1,123 @@
+#include "swcore/subproduct_file.h"
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace swcore {
+
+SubproductFile::SubproductFile(const QString &path) : m_path(path), m_file(path) {}
+
+SubproductFile::~SubproductFile() {
+    if (m_map) {
+        m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_map)));
+    }
+}
+
+bool SubproductFile::open() {
+    if (m_file.isOpen()) {
+        return true;
+    }
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size > 0) {
+        // Mapping can fail for huge files on 32-bit hosts or odd filesystems;
+        // reads then go through the QFile.
+        m_map = reinterpret_cast<const char *>(m_file.map(0, m_size));
+    }
+    return true;
+}
+
+bool SubproductFile::isOpen() const {
+    return m_file.isOpen();
+}
+
+bool SubproductFile::isMapped() const {
+    return m_map != nullptr;
+}
+
+const QString &SubproductFile::path() const {
+    return m_path;
+}
+
+qint64 SubproductFile::size() const {
+    return m_size;
+}
+
+const char *SubproductFile::view(qint64 offset, qint64 length) const {
+    if (!m_map || offset < 0 || length < 0 || offset > m_size || length > m_size - offset) {
+        return nullptr;
+    }
+    return m_map + offset;
+}
+
+qint64 SubproductFile::read(qint64 offset, char *dst, qint64 length) {
+    if (!dst || offset < 0 || length <= 0 || offset >= m_size) {
+        return 0;
+    }
+    const qint64 n = std::min(length, m_size - offset);
+    if (m_map) {
+        std::copy(m_map + offset, m_map + offset + n, dst);
+        return n;
+    }
+    if (!m_file.seek(offset)) {
+        return 0;
+    }
+    return std::max<qint64>(0, m_file.read(dst, n));
+}
+
+QByteArray SubproductFile::bytes(qint64 offset, qint64 length) {
+    if (offset < 0 || length <= 0 || offset >= m_size) {
+        return {};
+    }
+    const qint64 n = std::min(length, m_size - offset);
+    if (m_map) {
+        return QByteArray::fromRawData(m_map + offset, int(n));
+    }
+    if (!m_file.seek(offset)) {
+        return {};
+    }
+    return m_file.read(n);
+}
+
+void SubproductFile::adviseSequential() {
+#ifdef Q_OS_UNIX
+    if (m_map) {
+        madvise(const_cast<char *>(m_map), size_t(m_size), MADV_SEQUENTIAL);
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    if (m_file.isOpen()) {
+        posix_fadvise(m_file.handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+#endif
+#endif
+}
+
+void SubproductFile::willNeed(qint64 offset, qint64 length) {
+    if (offset < 0 || length <= 0 || offset >= m_size) {
+        return;
+    }
+    length = std::min(length, m_size - offset);
+#ifdef Q_OS_UNIX
+#ifdef POSIX_FADV_WILLNEED
+    if (m_file.isOpen()) {
+        posix_fadvise(m_file.handle(), off_t(offset), off_t(length), POSIX_FADV_WILLNEED);
+    }
+#else
+    // The mapping starts on a page boundary; advice ranges must too.
+    if (m_map) {
+        const qint64 page = qint64(sysconf(_SC_PAGESIZE));
+        const qint64 start = page > 0 ? offset - offset % page : offset;
+        madvise(const_cast<char *>(m_map) + start, size_t(offset + length - start), MADV_WILLNEED);
+    }
+#endif
+#endif
+}
+
+} // namespace swcore
@@ -0,0 +1,165 @@
+#include "swcore/wildcard.h"
+
+#include <QRegularExpression>
+
+#include <utility>
+
+namespace swcore {
+
+Wildcard::Wildcard(const QString &pattern) {
+    QString run;
+    auto flushRun = [&]() {
+        if (!run.isEmpty()) {
+            m_literals.push_back(run);
+            run.clear();
+        }
+    };
+
+    const int n = pattern.size();
+    for (int i = 0; i < n; ++i) {
+        const QChar c = pattern.at(i);
+        Token token;
+        if (c == '*') {
+            token.kind = Token::Star;
+        } else if (c == '?') {
+            token.kind = Token::Any;
+        } else if (c == '[') {
+            // A set runs to the next ']' (a leading ']' is literal); without
+            // one the '[' is an ordinary character.
+            int j = i + 1;
+            CharSet set;
+            if (j < n && (pattern.at(j) == '!' || pattern.at(j) == '^')) {
+                set.negated = true;
+                ++j;
+            }
+            const int first = j;
+            while (j < n && (pattern.at(j) != ']' || j == first)) {
+                const QChar lo = pattern.at(j);
+                QChar hi = lo;
+                if (j + 2 < n && pattern.at(j + 1) == '-' && pattern.at(j + 2) != ']') {
+                    hi = pattern.at(j + 2);
+                    j += 2;
+                }
+                set.ranges.emplace_back(lo, hi);
+                ++j;
+            }
+            if (j < n) {
+                token.kind = Token::Set;
+                token.set = int(m_sets.size());
+                m_sets.push_back(std::move(set));
+                i = j;
+            } else {
+                token.ch = c;
+            }
+        } else {
+            token.ch = c;
+        }
+
+        if (token.kind == Token::Char) {
+            run.append(token.ch);
+        } else {
+            flushRun();
+        }
+        // Consecutive stars behave like one.
+        if (token.kind == Token::Star && !m_tokens.empty() && m_tokens.back().kind == Token::Star) {
+            continue;
+        }
+        m_tokens.push_back(token);
+    }
+    flushRun();
+}
+
+bool Wildcard::hasWildcards(const QString &text) {
+    return text.contains('*') || text.contains('?') || text.contains('[');
+}
+
+bool Wildcard::matches(QStringView text) const {
+    // Greedy match that backtracks to the most recent '*'.
+    const size_t count = m_tokens.size();
+    const int n = int(text.size());
+    size_t p = 0;
+    int t = 0;
+    size_t starP = count;
+    int starT = 0;
+
+    while (t < n) {
+        if (p < count) {
+            const Token &token = m_tokens[p];
+            if (token.kind == Token::Star) {
+                starP = p++;
+                starT = t;
+                continue;
+            }
+            const QChar c = text.at(t);
+            const bool hit = token.kind == Token::Any || (token.kind == Token::Char && token.ch == c) ||
+                             (token.kind == Token::Set && setContains(token.set, c));
+            if (hit) {
+                ++p;
+                ++t;
+                continue;
+            }
+        }
+        if (starP == count) {
+            return false;
+        }
+        p = starP + 1;
+        t = ++starT;
+    }
+    while (p < count && m_tokens[p].kind == Token::Star) {
+        ++p;
+    }
+    return p == count;
+}
+
+bool Wildcard::setContains(int set, QChar c) const {
+    const CharSet &cs = m_sets[size_t(set)];
+    bool found = false;
+    for (const auto &range : cs.ranges) {
+        if (c >= range.first && c <= range.second) {
+            found = true;
+            break;
+        }
+    }
+    return found != cs.negated;
+}
+
+WildcardMask::WildcardMask(const QString &mask) {
+    static const QRegularExpression separators("[,\\s]+");
+    const QStringList parts = mask.split(separators, Qt::SkipEmptyParts);
+    bool includeAll = false;
+    for (const QString &part : parts) {
+        if (part.startsWith('!')) {
+            if (part.size() > 1) {
+                m_exclude.emplace_back(part.mid(1));
+            }
+        } else if (part == "*") {
+            includeAll = true;
+        } else {
+            m_include.emplace_back(part);
+        }
+    }
+    if (includeAll) {
+        m_include.clear();
+    }
+}
+
+bool WildcardMask::matches(QStringView subgroup) const {
+    bool selected = m_include.empty();
+    for (const Wildcard &w : m_include) {
+        if (w.matches(subgroup)) {
+            selected = true;
+            break;
+        }
+    }
+    if (!selected) {
+        return false;
+    }
+    for (const Wildcard &w : m_exclude) {
+        if (w.matches(subgroup)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace swcore